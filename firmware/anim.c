@@ -0,0 +1,33 @@
+#include <avr/pgmspace.h>
+#include "anim.h"
+
+void anim_play(struct anim_player *player, const struct anim *anim, const uint16_t NOW)
+{
+    player->anim = anim;
+    player->start = NOW;
+}
+
+uint8_t anim_draw(struct anim_player *player, const uint16_t NOW)
+{
+    const struct anim *anim = player->anim;
+    if (!anim)
+        return 0;
+
+    uint16_t index = (uint16_t) (NOW - player->start) / anim->ticks;
+    uint8_t running = index < anim->length - 1;
+    if (!running)
+        index = anim->length - 1;
+
+    uint8_t frame = pgm_read_byte(&anim->frames[index]);
+    if (frame != player->shown)
+    {
+        nokia_lcd_draw_sprite(player->x, player->y, anim->sprite, frame);
+        player->shown = frame;
+    }
+    return running;
+}
+
+void anim_reset(struct anim_player *player)
+{
+    player->shown = 0xFF;
+}
@@ -0,0 +1,57 @@
+#ifndef __ANIM_H__
+#define __ANIM_H__
+
+#include <stdint.h>
+#include "nokia5110.h"
+
+/**
+ * Sprite animations driven by the tick: the frame on the screen only depends on how many ticks have passed since the animation
+ * started, so it costs the same whether the render task runs late or not, and a frame is only drawn again when it changes.
+ */
+
+/**
+ * A sequence of frames of a sprite. The last frame stays on the screen once the animation is over.
+ */
+struct anim
+{
+    const struct nokia_lcd_sprite *sprite;
+    const uint8_t *frames;    // frame numbers of the sprite, in program memory
+    uint8_t length;           // how many frames
+    uint8_t ticks;            // how long each frame is shown, in ticks
+};
+
+/**
+ * An animation playing at a place of the screen.
+ */
+struct anim_player
+{
+    uint8_t x;
+    uint8_t y;
+    const struct anim *anim;  // NULL if nothing was played yet
+    uint16_t start;           // tick the animation started at
+    uint8_t shown;            // sprite frame on the screen, 0xFF if unknown
+};
+
+/**
+ * Starts an animation.
+ * @param player the player
+ * @param anim the animation
+ * @param NOW the current tick
+ */
+void anim_play(struct anim_player *player, const struct anim *anim, const uint16_t NOW);
+
+/**
+ * Draws the frame of the animation due at NOW, if it is not on the screen already.
+ * @param player the player
+ * @param NOW the current tick
+ * @return 1 while the animation is running, 0 once it is over (its last frame is shown)
+ */
+uint8_t anim_draw(struct anim_player *player, const uint16_t NOW);
+
+/**
+ * Forgets what the player shows, so the next anim_draw() draws the frame (e.g. after the screen was cleared).
+ * @param player the player
+ */
+void anim_reset(struct anim_player *player);
+
+#endif
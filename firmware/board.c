@@ -0,0 +1,17 @@
+#include <avr/pgmspace.h>
+#include "board.h"
+
+#define CELL(row, col)  { BOARD_X0 + (col) * BOARD_DX, BOARD_Y0 + (row) * BOARD_DY }
+#define ROW3(row)       CELL(row, 0), CELL(row, 1), CELL(row, 2)
+#define ROW4(row)       ROW3(row), CELL(row, 3)
+
+const struct board_whole BOARD_LAYOUT[BOARD_WHOLES] PROGMEM =
+{
+#if BOARD_WHOLES == 5
+    CELL(0, 1), CELL(1, 0), CELL(1, 1), CELL(1, 2), CELL(2, 1)
+#elif BOARD_WHOLES == 9
+    ROW3(0), ROW3(1), ROW3(2)
+#else
+    ROW4(0), ROW4(1), ROW4(2), ROW4(3)
+#endif
+};
@@ -0,0 +1,60 @@
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
+#include <stdint.h>
+
+/**
+ * Layout of the wholes on the screen. The wholes sit on the cells of a grid in the game area (left of the misses box and above
+ * the divider); their positions are computed at compile time into BOARD_LAYOUT, in program memory, in the order of the buttons:
+ *   5 wholes   the cells of a plus on a 3x3 grid, in the order of the W, A, S, D and X buttons
+ *   9 wholes   3x3 grid, read from a 3x3 keypad (KEYPAD, see buttons.h)
+ *   16 wholes  4x4 grid, read from a 4x4 keypad
+ * The number of wholes is set with BOARD in the Makefile.
+ */
+#ifndef BOARD_WHOLES
+#define BOARD_WHOLES  5
+#endif
+
+#if BOARD_WHOLES == 5
+#define BOARD_ROWS    3
+#define BOARD_COLS    3
+#define BOARD_X0      0     // top left corner of the sprite of the top left cell
+#define BOARD_Y0      0
+#define BOARD_DX      36    // distance between the cells
+#define BOARD_DY      14
+#define BOARD_KEYS    "WASDX"
+#elif BOARD_WHOLES == 9
+#define BOARD_ROWS    3
+#define BOARD_COLS    3
+#define BOARD_X0      2
+#define BOARD_Y0      0
+#define BOARD_DX      20
+#define BOARD_DY      14
+#define BOARD_KEYS    "123456789"
+#elif BOARD_WHOLES == 16
+#define BOARD_ROWS    4
+#define BOARD_COLS    4
+#define BOARD_X0      1
+#define BOARD_Y0      0
+#define BOARD_DX      14
+#define BOARD_DY      10
+#define BOARD_KEYS    "123A456B789C*0#D"
+#else
+#error "BOARD_WHOLES must be 5, 9 or 16"
+#endif
+
+/**
+ * Position of a whole: the top left corner of its sprite.
+ */
+struct board_whole
+{
+    uint8_t x;
+    uint8_t y;
+};
+
+/**
+ * Where each whole is, in program memory (whole i is read from button i, the label of its key is BOARD_KEYS[i]).
+ */
+extern const struct board_whole BOARD_LAYOUT[BOARD_WHOLES];
+
+#endif
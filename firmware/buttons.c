@@ -0,0 +1,237 @@
+#include <avr/interrupt.h>
+#include "buttons.h"
+#include "ticks.h"
+
+#define DEBOUNCE_COUNTS ((F_CPU / 1024) * BUTTONS_DEBOUNCE_MS / 1000) // Timer 2 counts, with the 1024 prescaler
+
+static struct button_event queue[BUTTONS_QUEUE_SIZE];
+static volatile uint8_t queue_head = 0;   // next free slot, only written by the interruption routines
+static volatile uint8_t queue_tail = 0;   // oldest event, only written by buttons_get()
+static volatile uint8_t dropped = 0;
+
+static void push(uint8_t button, uint8_t pressed, uint32_t time)
+{
+    uint8_t next = (queue_head + 1) & (BUTTONS_QUEUE_SIZE - 1);
+    if (next == queue_tail)
+    {
+        dropped++;
+        return;
+    }
+    queue[queue_head].button = button;
+    queue[queue_head].pressed = pressed;
+    queue[queue_head].time = time;
+    queue_head = next;
+}
+
+#ifdef KEYPAD
+
+#define ROW_COUNTS  (DEBOUNCE_COUNTS / BOARD_ROWS)  // Timer 2 counts each row is driven for: a whole scan takes a debounce window
+
+static buttons_mask_t level = 0;              // debounced keys (1 - pressed)
+static buttons_mask_t scan = 0;               // keys read down by the scan in progress
+static buttons_mask_t last_scan = 0;          // keys read down by the previous scan
+static uint8_t row = 0;                       // row driven low, its columns are read at the next interruption
+static uint32_t scan_time;                    // when the scan in progress started
+static uint32_t edge_time[BUTTONS_COUNT];     // when each key that is settling first moved
+static volatile uint8_t scanning = 0;
+
+/**
+ * Drives a row low. The other rows float, so two keys down on a column cannot short their rows.
+ */
+static void drive_row(const uint8_t ROW)
+{
+    DDRC = (DDRC & ~BUTTONS_ROWS) | (1 << (PC0 + ROW));
+}
+
+/**
+ * Interruption routine for the pin change on PD0-PD7. While the keypad is idle all the rows are low, so any key pulls its column
+ * down: the scan starts, and the keys it finds down moved when this interruption came.
+ */
+ISR(PCINT2_vect)
+{
+    if ((PIND & BUTTONS_PINS) == BUTTONS_PINS) // a bounce that already went away
+        return;
+
+    PCMSK2 &= ~BUTTONS_PINS;
+    scanning = 1;
+    scan_time = ticks_stamp();
+    scan = 0;
+    row = 0;
+    drive_row(0);
+
+    TCNT2 = 0;
+    TIFR2 = (1 << OCF2A);
+    TCCR2B = (1 << CS22) | (1 << CS21) | (1 << CS20); // 1024 prescaler
+}
+
+/**
+ * Interruption routine for Timer 2: reads the row driven since the previous interruption and drives the next one. After the last
+ * row, a key whose reading differs from its debounced state and is the same as in the previous scan is settled, and an event is
+ * queued for it. Once no key is down or settling, the keypad goes back to idle.
+ */
+ISR(TIMER2_COMPA_vect)
+{
+    buttons_mask_t columns = ~PIND >> BUTTONS_PIN0 & BUTTONS_MASK;
+    scan |= columns << (row * BOARD_COLS);
+    if (++row < BOARD_ROWS)
+    {
+        drive_row(row);
+        return;
+    }
+
+    buttons_mask_t moved = scan ^ last_scan;               // started moving during this scan
+    buttons_mask_t changed = (scan ^ level) & ~moved;      // read the same in two scans
+    for (uint8_t i = 0; moved | changed; i++, moved >>= 1, changed >>= 1)
+    {
+        if (moved & 1)
+            edge_time[i] = scan_time;
+        if (changed & 1)
+            push(i, !(level >> i & 1), edge_time[i]);
+    }
+    level ^= (scan ^ level) & ~(scan ^ last_scan);
+    last_scan = scan;
+    scan = 0;
+    row = 0;
+
+    if (!level && !last_scan)
+    {
+        // idle: all the rows low, and the pin change interruption waits for a key; a key pressed since the last row was read
+        // makes no edge, so the pins are checked once more
+        DDRC |= BUTTONS_ROWS;
+        PCIFR = (1 << PCIF2);
+        PCMSK2 |= BUTTONS_PINS;
+        if ((PIND & BUTTONS_PINS) == BUTTONS_PINS)
+        {
+            TCCR2B = 0;
+            scanning = 0;
+            return;
+        }
+        PCMSK2 &= ~BUTTONS_PINS;
+    }
+    scan_time = ticks_stamp();
+    drive_row(0);
+}
+
+void buttons_init()
+{
+    DDRD &= ~BUTTONS_PINS;    // columns -> input
+    PORTD |= BUTTONS_PINS;    // enabling internal pull-up
+    PORTC &= ~BUTTONS_ROWS;   // rows -> low, all of them while the keypad is idle
+    DDRC |= BUTTONS_ROWS;
+
+    // Timer 2 in CTC mode, stopped until a key is pressed
+    TCCR2A = (1 << WGM21);
+    TCCR2B = 0;
+    OCR2A = ROW_COUNTS - 1;
+    TIMSK2 |= (1 << OCIE2A);
+
+    PCMSK2 |= BUTTONS_PINS;
+    PCIFR = (1 << PCIF2);
+    PCICR |= (1 << PCIE2);
+}
+
+uint8_t buttons_busy()
+{
+    return scanning;
+}
+
+buttons_mask_t buttons_state()
+{
+    return level;
+}
+
+#else
+
+static volatile uint8_t level = BUTTONS_PINS; // last debounced level of the pins (1 - released)
+static volatile uint8_t settling = 0;         // pins waiting for the debounce window to end
+static uint32_t edge_time[BUTTONS_COUNT];     // when each settling pin first moved
+
+/**
+ * Interruption routine for the pin change on PD0-PD7. The pins that moved are masked until the debounce window is over, so the
+ * bouncing does not generate more interruptions.
+ */
+ISR(PCINT2_vect)
+{
+    uint8_t moved = ((PIND & BUTTONS_PINS) ^ level) & PCMSK2;
+    if (!moved)
+        return;
+
+    uint32_t now = ticks_stamp();
+    for (uint8_t i = 0; i < BUTTONS_COUNT; i++)
+        if (moved & (1 << (BUTTONS_PIN0 + i)))
+            edge_time[i] = now;
+    PCMSK2 &= ~moved;
+    settling |= moved;
+
+    // (re)starts the debounce window
+    TCNT2 = 0;
+    TIFR2 = (1 << OCF2A);
+    TCCR2B = (1 << CS22) | (1 << CS21) | (1 << CS20); // 1024 prescaler
+}
+
+/**
+ * Interruption routine for Timer 2, at the end of the debounce window.
+ */
+ISR(TIMER2_COMPA_vect)
+{
+    TCCR2B = 0; // stops Timer 2 until the next edge
+
+    // listens to the pins again before sampling them, so a change right after the sample is not lost
+    PCMSK2 |= settling;
+    uint8_t changed = ((PIND & BUTTONS_PINS) ^ level) & settling;
+    settling = 0;
+
+    for (uint8_t i = 0; i < BUTTONS_COUNT; i++)
+        if (changed & (1 << (BUTTONS_PIN0 + i)))
+            push(i, (level & (1 << (BUTTONS_PIN0 + i))) != 0, edge_time[i]); // was released, so it is a press
+    level ^= changed;
+}
+
+void buttons_init()
+{
+    DDRD &= ~BUTTONS_PINS;  // PD4 to PD0 (PD6 to PD2 with the telemetry) -> input
+    PORTD |= BUTTONS_PINS;  // enabling internal pull-up
+    level = PIND & BUTTONS_PINS;
+
+    // Timer 2 in CTC mode, stopped until an edge arrives
+    TCCR2A = (1 << WGM21);
+    TCCR2B = 0;
+    OCR2A = DEBOUNCE_COUNTS - 1;
+    TIMSK2 |= (1 << OCIE2A);
+
+    PCMSK2 |= BUTTONS_PINS;
+    PCIFR = (1 << PCIF2);
+    PCICR |= (1 << PCIE2);
+}
+
+uint8_t buttons_busy()
+{
+    return settling != 0;
+}
+
+buttons_mask_t buttons_state()
+{
+    return (~level & BUTTONS_PINS) >> BUTTONS_PIN0;
+}
+
+#endif
+
+uint8_t buttons_get(struct button_event *event)
+{
+    uint8_t tail = queue_tail;
+    if (tail == queue_head)
+        return 0;
+    *event = queue[tail];
+    queue_tail = (tail + 1) & (BUTTONS_QUEUE_SIZE - 1);
+    return 1;
+}
+
+uint8_t buttons_pending()
+{
+    return queue_tail != queue_head;
+}
+
+uint8_t buttons_dropped()
+{
+    return dropped;
+}
@@ -0,0 +1,87 @@
+#ifndef __BUTTONS_H__
+#define __BUTTONS_H__
+
+#include <avr/io.h>
+#include <stdint.h>
+
+/**
+ * Buttons are on PD0 to PD4 (active low, with the internal pull-ups enabled). Button i is the one on PD(BUTTONS_PIN0 + i). With
+ * the telemetry on, PD1 is the USART TX pin, so the buttons move to PD2 to PD6.
+ *
+ * With KEYPAD, the buttons are the keys of a BOARD_ROWS x BOARD_COLS matrix instead (see board.h): the columns are read on
+ * PD(BUTTONS_PIN0) on (with the pull-ups enabled) and the rows are driven low on PC0 on, one at a time, so 4 + 4 pins serve 16
+ * keys. Key i is the one on row i / BOARD_COLS and column i % BOARD_COLS. Every key has its own debounce, and any number of keys
+ * can be down at once (n-key rollover, with a diode in series with each key so pressed keys cannot create ghost ones).
+ */
+#ifdef KEYPAD
+#include "board.h"
+#define BUTTONS_COUNT        (BOARD_ROWS * BOARD_COLS)
+#define BUTTONS_ROWS         (((1 << BOARD_ROWS) - 1) << PC0)
+#define BUTTONS_MASK         ((1 << BOARD_COLS) - 1)      // the columns
+#else
+#define BUTTONS_COUNT        5
+#define BUTTONS_MASK         ((1 << BUTTONS_COUNT) - 1)
+#endif
+#ifdef TELEMETRY
+#define BUTTONS_PIN0         PD2
+#else
+#define BUTTONS_PIN0         PD0
+#endif
+#define BUTTONS_PINS         (BUTTONS_MASK << BUTTONS_PIN0)
+#define BUTTONS_DEBOUNCE_MS  5      // how long a pin must be left alone after an edge before it is sampled (a keypad scan)
+#define BUTTONS_QUEUE_SIZE   8      // events the queue can hold, must be a power of two
+
+/**
+ * A set of buttons, bit i set: button i.
+ */
+#if BUTTONS_COUNT > 8
+typedef uint16_t buttons_mask_t;
+#else
+typedef uint8_t buttons_mask_t;
+#endif
+
+/**
+ * A debounced press or release.
+ */
+struct button_event
+{
+    uint8_t button;   // which button (0 to BUTTONS_COUNT-1)
+    uint8_t pressed;  // 1 - pressed; 0 - released
+    uint32_t time;    // ticks_stamp() of the first edge
+};
+
+/**
+ * Configures the pins, the pin change interruption (PCINT2) and Timer 2, which times the debounce window (or the keypad scan).
+ * The events are only generated while interruptions are enabled.
+ */
+void buttons_init();
+
+/**
+ * Takes the oldest event from the queue. The queue is filled by the interruption routines only and emptied by the caller only,
+ * so no locking is needed.
+ * @param event where the event is stored
+ * @return 1 if an event was taken, 0 if the queue is empty
+ */
+uint8_t buttons_get(struct button_event *event);
+
+/**
+ * @return 1 if there are events in the queue, 0 otherwise
+ */
+uint8_t buttons_pending();
+
+/**
+ * @return 1 if a debounce window is open or the keypad is being scanned (Timer 2 is running), 0 otherwise
+ */
+uint8_t buttons_busy();
+
+/**
+ * @return the debounced state of the buttons, bit i set if button i is pressed
+ */
+buttons_mask_t buttons_state();
+
+/**
+ * @return how many events were dropped because the queue was full
+ */
+uint8_t buttons_dropped();
+
+#endif
@@ -0,0 +1,62 @@
+#include <string.h>
+#include "fmt.h"
+#include "nokia5110.h"
+#include "prof.h"
+
+static const uint16_t POWERS[FMT_U16_DIGITS - 1] = { 10000, 1000, 100, 10 };
+
+uint8_t fmt_u16(char *buf, const uint16_t VALUE)
+{
+    PROF_SCOPE(PROF_FORMAT);
+
+    // repeated subtraction: at most 9 per digit, far cheaper than a 16 bit division on the AVR
+    uint16_t value = VALUE;
+    uint8_t length = 0;
+    for (uint8_t i = 0; i < FMT_U16_DIGITS - 1; i++)
+    {
+        char digit = '0';
+        while (value >= POWERS[i])
+        {
+            value -= POWERS[i];
+            digit++;
+        }
+        if (length || digit != '0')
+            buf[length++] = digit;
+    }
+    buf[length++] = '0' + value;
+    buf[length] = '\0';
+    return length;
+}
+
+void fmt_field_draw(struct fmt_field *field, const uint16_t VALUE)
+{
+    char digits[FMT_U16_DIGITS + 1];
+    uint8_t length = fmt_u16(digits, VALUE);
+    // shown[] holds FMT_U16_DIGITS characters, which is as wide as a number gets: a wider field would lose its last ones
+    uint8_t width = field->width > FMT_U16_DIGITS ? FMT_U16_DIGITS : field->width;
+    if (length > width)
+        width = length;
+    uint8_t pad = width - length;
+
+    for (uint8_t i = 0; i < FMT_U16_DIGITS; i++)
+    {
+        char c;
+        if (i >= width)
+            c = field->shown[i] ? ' ' : '\0'; // erases what a longer number left past the field
+        else if (field->left)
+            c = i < length ? digits[i] : ' ';
+        else
+            c = i < pad ? ' ' : digits[i - pad];
+
+        if (c == field->shown[i])
+            continue;
+        field->shown[i] = c;
+        nokia_lcd_set_cursor(field->x + i * FMT_CHAR_WIDTH, field->y);
+        nokia_lcd_write_char(c, 1);
+    }
+}
+
+void fmt_field_reset(struct fmt_field *field)
+{
+    memset(field->shown, 0, sizeof(field->shown));
+}
@@ -0,0 +1,46 @@
+#ifndef __FMT_H__
+#define __FMT_H__
+
+#include <stdint.h>
+
+/**
+ * Number formatting without printf: decimal conversion of uint16_t, and fixed-width numeric fields drawn straight into the LCD
+ * buffer, where only the characters that changed since the last draw are written again.
+ */
+#define FMT_U16_DIGITS  5    // digits of the largest uint16_t
+#define FMT_CHAR_WIDTH  6    // pixels per character, at scale 1 (5 columns and the gap)
+
+/**
+ * A number shown at a fixed place on the screen.
+ */
+struct fmt_field
+{
+    uint8_t x;                      // position of the first character
+    uint8_t y;
+    uint8_t width;                  // characters (up to FMT_U16_DIGITS); a number with more digits is drawn whole, past the field
+    uint8_t left;                   // 1 - left aligned; 0 - right aligned
+    char shown[FMT_U16_DIGITS];     // characters on the screen, '\0' if unknown
+};
+
+/**
+ * Converts a number to decimal, without leading zeros.
+ * @param buf where the digits are written, followed by '\0' (FMT_U16_DIGITS + 1 bytes at least)
+ * @param VALUE the number
+ * @return how many digits were written
+ */
+uint8_t fmt_u16(char *buf, const uint16_t VALUE);
+
+/**
+ * Draws a number in a field (at scale 1), writing only the characters that differ from the ones on the screen.
+ * @param field the field
+ * @param VALUE the number
+ */
+void fmt_field_draw(struct fmt_field *field, const uint16_t VALUE);
+
+/**
+ * Forgets what the field shows, so the next draw writes all of it (e.g. after the screen is cleared).
+ * @param field the field
+ */
+void fmt_field_reset(struct fmt_field *field);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef __HOST_AVR_INTERRUPT_H__
+#define __HOST_AVR_INTERRUPT_H__
+
+#include <avr/io.h>
+
+/*
+ * Interruption routines become plain functions, which the host code calls
+ * to simulate the interruption (e.g. TIMER1_COMPA_vect() for a tick)
+ */
+#define ISR(vector) void vector(void); void vector(void)
+
+#define sei()
+#define cli()
+
+#endif
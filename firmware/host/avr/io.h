@@ -0,0 +1,77 @@
+#ifndef __HOST_AVR_IO_H__
+#define __HOST_AVR_IO_H__
+
+#include <stdint.h>
+
+/*
+ * ATmega328P registers used by the firmware, as plain variables (defined in
+ * io.c). Nothing happens when they are written, except for the SPI data and
+ * status registers, which feed the LCD capture (see lcd_capture.c).
+ */
+extern volatile uint8_t PORTB, DDRB, PINB;
+extern volatile uint8_t PORTC, DDRC, PINC;
+extern volatile uint8_t PORTD, DDRD, PIND;
+extern volatile uint8_t SPCR;
+extern volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+extern volatile uint16_t TCNT1, OCR1A;
+extern volatile uint8_t TCCR2A, TCCR2B, TCNT2, OCR2A, TIMSK2, TIFR2;
+extern volatile uint8_t PCICR, PCIFR, PCMSK2;
+extern volatile uint8_t SMCR, SREG;
+extern volatile uint8_t ADMUX, ADCSRA;
+extern volatile uint16_t ADC;
+extern volatile uint8_t EECR, EEDR;
+extern volatile uint16_t EEAR;
+
+volatile uint8_t *host_spdr(void);
+volatile uint8_t *host_spsr(void);
+#define SPDR (*host_spdr())
+#define SPSR (*host_spsr())
+
+enum { PB0, PB1, PB2, PB3, PB4, PB5, PB6, PB7 };
+enum { PC0, PC1, PC2, PC3, PC4, PC5, PC6 };
+enum { PD0, PD1, PD2, PD3, PD4, PD5, PD6, PD7 };
+
+/* SPCR, SPSR */
+#define SPIE 7
+#define SPE 6
+#define MSTR 4
+#define SPR1 1
+#define SPR0 0
+#define SPIF 7
+#define SPI2X 0
+
+/* Timer 1 */
+#define WGM12 3
+#define CS12 2
+#define CS11 1
+#define CS10 0
+#define OCIE1A 1
+#define OCF1A 1
+
+/* Timer 2 */
+#define WGM21 1
+#define CS22 2
+#define CS21 1
+#define CS20 0
+#define OCIE2A 1
+#define OCF2A 1
+
+/* ADC */
+#define REFS1 7
+#define REFS0 6
+#define MUX3 3
+#define ADEN 7
+#define ADSC 6
+#define ADPS1 1
+
+/* EEPROM */
+#define EERIE 3
+#define EEMPE 2
+#define EEPE 1
+#define EERE 0
+
+/* Pin change interruption */
+#define PCIE2 2
+#define PCIF2 2
+
+#endif
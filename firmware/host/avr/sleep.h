@@ -0,0 +1,17 @@
+#ifndef __HOST_AVR_SLEEP_H__
+#define __HOST_AVR_SLEEP_H__
+
+/*
+ * Sleeping does nothing on the host, so code that sleeps until an
+ * interruption arrives must not be run there
+ */
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_PWR_DOWN 2
+
+#define set_sleep_mode(mode) ((void) (mode))
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_bod_disable()
+#define sleep_cpu()
+
+#endif
@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "../nokia5110.h"
+#include "../fonts.h"
+#include "../ticks.h"
+#include "../anim.h"
+#include "../sprites.h"
+#include "../board.h"
+#include "lcd_capture.h"
+
+/**
+ * Micro-benchmarks of the LCD driver and of the game rendering, run on the development machine. The times only make sense
+ * compared with each other (and with a previous run), the bytes per operation are what the display would receive on the target.
+ *
+ * Usage: bench [pbm file], the display after the last benchmark is written to the file.
+ */
+
+#define MIN_BENCH_NS  200000000ULL  // each benchmark runs at least this long
+
+// game state and game functions, from main.c (compiled with main renamed to firmware_main)
+extern uint8_t misses_sequence;
+extern uint16_t points_counter;
+extern bool table_redraw;
+extern bool fields_redraw;
+extern struct anim_player wholes[];
+void TIMER1_COMPA_vect(void);
+void render_layout();
+void task_render_table();
+void task_render_fields();
+
+struct bench
+{
+    const char *name;
+    void (*setup)();            // optional, runs once before the timed loop
+    void (*run)(const uint32_t I);
+    bool piles_up;              // draws something new every run, more than the display list of LCD_TILES can hold
+};
+
+static void setup_clear()
+{
+    nokia_lcd_clear();
+    nokia_lcd_render();
+}
+
+static void run_write_string(const uint32_t I)
+{
+    nokia_lcd_set_cursor(0, 0);
+    nokia_lcd_write_string(I & 1 ? "WHAC-A-MOLE!" : "(W to start)", 1);
+}
+
+static void run_write_string_x2(const uint32_t I)
+{
+    nokia_lcd_set_cursor(20, 0);
+    nokia_lcd_write_string(I & 1 ? "GAME" : "OVER", 2);
+}
+
+static void run_write_string_small(const uint32_t I)
+{
+    nokia_lcd_write_string_centered(I & 1 ? "WHAC-A-MOLE!" : "(W to start)", 10, &FONT_SMALL);
+}
+
+static void run_write_string_medium(const uint32_t I)
+{
+    nokia_lcd_write_string_centered(I & 1 ? "GAME" : "OVER", 0, &FONT_MEDIUM);
+}
+
+static void run_drawline_diagonal(const uint32_t I)
+{
+    nokia_lcd_drawline(0, I % 48, 83, 47 - I % 48);
+}
+
+static void run_drawline_horizontal(const uint32_t I)
+{
+    nokia_lcd_drawline(0, I % 48, 84, I % 48);
+}
+
+static void setup_title()
+{
+    nokia_lcd_clear();
+    nokia_lcd_drawrect(0, 0, 83, 47);
+    nokia_lcd_set_cursor(7, 10);
+    nokia_lcd_write_string("WHAC-A-MOLE!", 1);
+    nokia_lcd_render();
+}
+
+static void run_render_full(const uint32_t I)
+{
+    nokia_lcd_invalidate();
+    nokia_lcd_render();
+}
+
+static void run_render_glyph(const uint32_t I)
+{
+    nokia_lcd_set_cursor(37, 13);
+    nokia_lcd_write_char(I & 1 ? '&' : 'O', 1);
+    nokia_lcd_render();
+}
+
+static void setup_game()
+{
+    render_layout();
+    points_counter = 0;
+    misses_sequence = 0;
+    table_redraw = fields_redraw = true;
+    task_render_table();
+    task_render_fields();
+}
+
+static void run_game_frame(const uint32_t I)
+{
+    points_counter = I % 1000;
+    misses_sequence = I % 15;
+    table_redraw = fields_redraw = true;
+    task_render_table();
+    task_render_fields();
+}
+
+/**
+ * All the wholes animated at once: every frame time one of the animations moves to its next frame, and they are restarted
+ * (whacked and popping up in turns) once they are over.
+ */
+static void run_animate_wholes(const uint32_t I)
+{
+    for (uint8_t t = 0; t < MS_TO_TICKS(50); t++)
+        TIMER1_COMPA_vect();
+    if (I % 6 == 0)
+        for (uint8_t i = 0; i < BOARD_WHOLES; i++)
+            anim_play(&wholes[i], (I / 6 + i) & 1 ? &MOLE_WHACKED : &MOLE_POPUP, ticks_now());
+    table_redraw = true;
+    task_render_table();
+}
+
+static const struct bench benches[] =
+{
+    { "write_string x1",     setup_clear, run_write_string },
+    { "write_string x2",     setup_clear, run_write_string_x2 },
+    { "font x1 centered",    setup_clear, run_write_string_small },
+    { "font x2 centered",    setup_clear, run_write_string_medium },
+    { "drawline diagonal",   setup_clear, run_drawline_diagonal, true },
+    { "drawline horizontal", setup_clear, run_drawline_horizontal },
+    { "render full",         setup_title, run_render_full },
+    { "render one glyph",    setup_title, run_render_glyph },
+    { "game frame",          setup_game,  run_game_frame },
+    { "animate all wholes",  setup_game,  run_animate_wholes },
+};
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Checks that the display matches the screen buffer of the driver, by comparing it with a full render of the buffer. Catches
+ * changes that were drawn but never sent (e.g. a dirty span that was not marked).
+ * @return true if the display is right
+ */
+static bool display_matches()
+{
+    uint8_t shown[504];
+    nokia_lcd_render();
+    memcpy(shown, lcd_capture_ram(), sizeof(shown));
+    nokia_lcd_invalidate();
+    nokia_lcd_render();
+    return memcmp(shown, lcd_capture_ram(), sizeof(shown)) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    nokia_lcd_init();
+    lcd_capture_reset();
+
+    bool ok = true;
+    printf("%-20s %12s %12s\n", "benchmark", "ns/op", "bytes/op");
+    for (uint8_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++)
+    {
+        const struct bench *bench = &benches[b];
+        if (bench->setup)
+            bench->setup();
+
+        uint32_t iterations = 0;
+        uint8_t dropped = nokia_lcd_dropped();
+        uint32_t bytes = lcd_capture_data_bytes() + lcd_capture_cmd_bytes();
+        uint64_t start = now_ns(), elapsed;
+        do
+        {
+            for (uint32_t i = 0; i < 1000; i++)
+                bench->run(iterations++);
+            elapsed = now_ns() - start;
+        } while (elapsed < MIN_BENCH_NS);
+        bytes = lcd_capture_data_bytes() + lcd_capture_cmd_bytes() - bytes;
+
+        bool matches = display_matches();
+        bool fits = bench->piles_up || nokia_lcd_dropped() == dropped;
+        ok = ok && matches && fits;
+        printf("%-20s %12.1f %12.1f%s%s\n", bench->name, (double) elapsed / iterations, (double) bytes / iterations,
+               matches ? "" : "  DISPLAY MISMATCH", fits ? "" : "  DISPLAY LIST FULL");
+    }
+
+    if (argc > 1)
+    {
+        FILE *out = fopen(argv[1], "w");
+        if (!out)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+        lcd_capture_write_pbm(out);
+        fclose(out);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../nokia5110.h"
+#include "../fonts.h"
+#include "lcd_capture.h"
+
+/**
+ * Build-time tool: draws the backgrounds described in a text file (see backgrounds.txt) with the LCD driver, captures the
+ * resulting display RAM and writes it as PROGMEM arrays, to be loaded with nokia_lcd_load_P().
+ *
+ * Usage: bgtool DESCRIPTION OUTPUT, writes OUTPUT.c and OUTPUT.h
+ */
+
+#define MAX_BACKGROUNDS  16
+#define NAME_SIZE        32
+
+struct background
+{
+    char name[NAME_SIZE];
+    uint8_t image[504];
+};
+
+static struct background backgrounds[MAX_BACKGROUNDS];
+static int count = 0;
+
+/**
+ * Captures the screen of the driver as the image of the current background.
+ */
+static void capture()
+{
+    if (!count)
+        return;
+    nokia_lcd_invalidate();
+    nokia_lcd_render();
+    memcpy(backgrounds[count - 1].image, lcd_capture_ram(), 504);
+}
+
+/**
+ * Fonts by name, for the font and center commands.
+ */
+static const struct
+{
+    const char *name;
+    const struct nokia_lcd_font *font;
+} FONTS[] =
+{
+    { "SMALL",  &FONT_SMALL },
+    { "MEDIUM", &FONT_MEDIUM },
+    { "LARGE",  &FONT_LARGE },
+};
+
+static const struct nokia_lcd_font *find_font(const char *NAME)
+{
+    for (unsigned i = 0; i < sizeof(FONTS) / sizeof(FONTS[0]); i++)
+        if (!strcmp(FONTS[i].name, NAME))
+            return FONTS[i].font;
+    return NULL;
+}
+
+static int fail(const char *path, const int LINE, const char *message)
+{
+    fprintf(stderr, "%s:%d: %s\n", path, LINE, message);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s DESCRIPTION OUTPUT\n", argv[0]);
+        return 2;
+    }
+    FILE *in = fopen(argv[1], "r");
+    if (!in)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    nokia_lcd_init();
+    char line[128];
+    int number = 0;
+    while (fgets(line, sizeof(line), in))
+    {
+        number++;
+        line[strcspn(line, "\r\n")] = '\0';
+        char command[16];
+        int n = 0;
+        if (sscanf(line, "%15s%n", command, &n) != 1 || command[0] == '#')
+            continue;
+
+        unsigned a, b, c, d;
+        int text = 0;
+        char font[16];
+        if (!strcmp(command, "background"))
+        {
+            capture();
+            if (count == MAX_BACKGROUNDS)
+                return fail(argv[1], number, "too many backgrounds");
+            struct background *bg = &backgrounds[count++];
+            if (sscanf(line + n, "%31s", bg->name) != 1)
+                return fail(argv[1], number, "background without a name");
+            for (char *p = bg->name; *p; p++)
+                if (!isalnum((unsigned char) *p) && *p != '_')
+                    return fail(argv[1], number, "the name must be a C identifier");
+            nokia_lcd_clear();
+        }
+        else if (!count)
+            return fail(argv[1], number, "drawing before the first background");
+        else if (!strcmp(command, "rect") && sscanf(line + n, "%u %u %u %u", &a, &b, &c, &d) == 4)
+            nokia_lcd_drawrect(a, b, c, d);
+        else if (!strcmp(command, "line") && sscanf(line + n, "%u %u %u %u", &a, &b, &c, &d) == 4)
+            nokia_lcd_drawline(a, b, c, d);
+        else if (!strcmp(command, "text") && sscanf(line + n, "%u %u %u %n", &a, &b, &c, &text) == 3 && text)
+        {
+            nokia_lcd_set_cursor(a, b);
+            nokia_lcd_write_string(line + n + text, c);
+        }
+        else if (!strcmp(command, "font") && sscanf(line + n, "%u %u %15s %n", &a, &b, font, &text) == 3 && text)
+        {
+            if (!find_font(font))
+                return fail(argv[1], number, "unknown font");
+            nokia_lcd_set_cursor(a, b);
+            nokia_lcd_write_string_font(line + n + text, find_font(font));
+        }
+        else if (!strcmp(command, "center") && sscanf(line + n, "%u %15s %n", &b, font, &text) == 2 && text)
+        {
+            if (!find_font(font))
+                return fail(argv[1], number, "unknown font");
+            nokia_lcd_write_string_centered(line + n + text, b, find_font(font));
+        }
+        else
+            return fail(argv[1], number, "unknown command or wrong arguments");
+    }
+    fclose(in);
+    capture();
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s.h", argv[2]);
+    FILE *h = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.c", argv[2]);
+    FILE *c = fopen(path, "w");
+    if (!h || !c)
+    {
+        perror(path);
+        return 1;
+    }
+
+    fprintf(h, "/* Generated by host/bgtool from %s, do not edit */\n\n", argv[1]);
+    fprintf(h, "#ifndef __BACKGROUNDS_H__\n#define __BACKGROUNDS_H__\n\n#include <avr/pgmspace.h>\n#include <stdint.h>\n\n");
+    fprintf(c, "/* Generated by host/bgtool from %s, do not edit */\n\n#include \"%s.h\"\n", argv[1], argv[2]);
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(h, "extern const uint8_t BG_%s[504] PROGMEM;\n", backgrounds[i].name);
+        fprintf(c, "\nconst uint8_t BG_%s[504] PROGMEM =\n{", backgrounds[i].name);
+        for (int j = 0; j < 504; j++)
+            fprintf(c, "%s0x%02X,", j % 12 ? " " : "\n    ", backgrounds[i].image[j]);
+        fprintf(c, "\n};\n");
+    }
+    fprintf(h, "\n#endif\n");
+    fclose(h);
+    fclose(c);
+    return 0;
+}
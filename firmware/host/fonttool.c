@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../nokia5110_chars.h"
+
+/**
+ * Build-time tool: turns the fixed 5x7 CHARSET into proportional fonts, one per size, with the empty columns around each
+ * glyph trimmed and the larger sizes scaled here rather than on the microcontroller. The fonts are written as PROGMEM
+ * tables for nokia_lcd_write_string_font().
+ *
+ * Usage: fonttool OUTPUT, writes OUTPUT.c and OUTPUT.h
+ */
+
+#define FIRST_CHAR   ' '
+#define LAST_CHAR    '~'
+#define GLYPHS       (LAST_CHAR - FIRST_CHAR + 1)
+#define SPACE_WIDTH  2     // width of the blank glyphs, in columns of the 5x7 font
+
+struct size
+{
+    const char *name;
+    unsigned scale;
+};
+
+/**
+ * Generated fonts: FONT_<name>, 7 * scale rows high.
+ */
+static const struct size SIZES[] =
+{
+    { "SMALL",  1 },
+    { "MEDIUM", 2 },
+    { "LARGE",  3 },
+};
+
+/**
+ * Finds the columns of a 5x7 glyph that have pixels.
+ * @param C character
+ * @param first first column with pixels, set to 0 for a blank glyph
+ * @return how many columns from the first one on are kept
+ */
+static unsigned trim(const int C, unsigned *first)
+{
+    unsigned last = 0;
+    *first = 5;
+    for (unsigned x = 0; x < 5; x++)
+        if (CHARSET[C - ' '][x] & 0x7F)
+        {
+            if (*first == 5)
+                *first = x;
+            last = x;
+        }
+    if (*first == 5)
+    {
+        *first = 0;
+        return SPACE_WIDTH;
+    }
+    return last - *first + 1;
+}
+
+/**
+ * Writes one font: the width and the offset of each glyph, then the columns of all the glyphs.
+ */
+static void write_font(FILE *c, FILE *h, const struct size *SIZE)
+{
+    const unsigned HEIGHT = 7 * SIZE->scale;
+    const unsigned BYTES = (HEIGHT + 7) / 8;
+    unsigned offset = 0;
+
+    fprintf(h, "extern const struct nokia_lcd_font FONT_%s;  // %u rows\n", SIZE->name, HEIGHT);
+
+    fprintf(c, "\nstatic const uint8_t FONT_%s_WIDTHS[%d] PROGMEM =\n{", SIZE->name, GLYPHS);
+    for (int ch = FIRST_CHAR; ch <= LAST_CHAR; ch++)
+    {
+        unsigned first;
+        fprintf(c, "%s%u,", (ch - FIRST_CHAR) % 16 ? " " : "\n    ", trim(ch, &first) * SIZE->scale);
+    }
+    fprintf(c, "\n};\n");
+
+    fprintf(c, "\nstatic const uint16_t FONT_%s_OFFSETS[%d] PROGMEM =\n{", SIZE->name, GLYPHS);
+    for (int ch = FIRST_CHAR; ch <= LAST_CHAR; ch++)
+    {
+        unsigned first;
+        fprintf(c, "%s%u,", (ch - FIRST_CHAR) % 12 ? " " : "\n    ", offset);
+        offset += trim(ch, &first) * SIZE->scale * BYTES;
+    }
+    fprintf(c, "\n};\n");
+
+    fprintf(c, "\nstatic const uint8_t FONT_%s_BITMAP[%u] PROGMEM =\n{", SIZE->name, offset);
+    for (int ch = FIRST_CHAR; ch <= LAST_CHAR; ch++)
+    {
+        unsigned first;
+        const unsigned WIDTH = trim(ch, &first);
+        fprintf(c, "\n    /* '%c' */", ch);
+        for (unsigned x = first; x < first + WIDTH; x++)
+        {
+            // every bit of the column repeated scale times, then the column itself
+            const uint8_t COLUMN = x < 5 ? CHARSET[ch - ' '][x] & 0x7F : 0;
+            uint32_t bits = 0;
+            for (unsigned y = 0; y < HEIGHT; y++)
+                if (COLUMN & 1 << y / SIZE->scale)
+                    bits |= 1UL << y;
+            for (unsigned r = 0; r < SIZE->scale; r++)
+                for (unsigned i = 0; i < BYTES; i++)
+                    fprintf(c, " 0x%02X,", (unsigned) (bits >> 8 * i) & 0xFF);
+        }
+    }
+    fprintf(c, "\n};\n");
+
+    fprintf(c, "\nconst struct nokia_lcd_font FONT_%s = { %u, %u, '%c', '%c', FONT_%s_WIDTHS, FONT_%s_OFFSETS, "
+            "FONT_%s_BITMAP };\n", SIZE->name, HEIGHT, SIZE->scale, FIRST_CHAR, LAST_CHAR, SIZE->name, SIZE->name,
+            SIZE->name);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s OUTPUT\n", argv[0]);
+        return 2;
+    }
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s.h", argv[1]);
+    FILE *h = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.c", argv[1]);
+    FILE *c = fopen(path, "w");
+    if (!h || !c)
+    {
+        perror(path);
+        return 1;
+    }
+
+    fprintf(h, "/* Generated by host/fonttool from nokia5110_chars.h, do not edit */\n\n");
+    fprintf(h, "#ifndef __FONTS_H__\n#define __FONTS_H__\n\n#include \"nokia5110.h\"\n\n");
+    fprintf(c, "/* Generated by host/fonttool from nokia5110_chars.h, do not edit */\n\n#include <avr/pgmspace.h>\n");
+    fprintf(c, "#include \"%s.h\"\n", argv[1]);
+    for (unsigned i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); i++)
+        write_font(c, h, &SIZES[i]);
+    fprintf(h, "\n#endif\n");
+    fclose(h);
+    fclose(c);
+    return 0;
+}
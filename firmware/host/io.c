@@ -0,0 +1,15 @@
+#include <avr/io.h>
+
+volatile uint8_t PORTB, DDRB, PINB;
+volatile uint8_t PORTC, DDRC, PINC;
+volatile uint8_t PORTD, DDRD, PIND = 0xFF; // buttons released (active low)
+volatile uint8_t SPCR;
+volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, OCR1A;
+volatile uint8_t TCCR2A, TCCR2B, TCNT2, OCR2A, TIMSK2, TIFR2;
+volatile uint8_t PCICR, PCIFR, PCMSK2;
+volatile uint8_t SMCR, SREG;
+volatile uint8_t ADMUX, ADCSRA;
+volatile uint16_t ADC;
+volatile uint8_t EECR, EEDR;
+volatile uint16_t EEAR;
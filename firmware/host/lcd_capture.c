@@ -0,0 +1,107 @@
+#include <string.h>
+#include <avr/io.h>
+#include "../nokia5110.h"
+#include "lcd_capture.h"
+
+#define BANKS (LCD_CAPTURE_HEIGHT / 8)
+
+static struct
+{
+    uint8_t ram[BANKS * LCD_CAPTURE_WIDTH];
+    uint8_t x;
+    uint8_t bank;
+    uint8_t extended;   // H bit of the last function set, the extended instruction set is selected
+    uint32_t data_bytes;
+    uint32_t cmd_bytes;
+} lcd;
+
+static uint8_t spdr;
+static uint8_t spsr;
+static uint8_t loaded = 0; // SPDR was written and the byte is not out yet
+
+/**
+ * Decodes one byte received by the controller.
+ */
+static void receive(const uint8_t BYTE, const uint8_t IS_DATA)
+{
+    if (IS_DATA)
+    {
+        lcd.data_bytes++;
+        lcd.ram[lcd.bank * LCD_CAPTURE_WIDTH + lcd.x] = BYTE;
+        if (++lcd.x == LCD_CAPTURE_WIDTH)
+        {
+            lcd.x = 0;
+            lcd.bank = (lcd.bank + 1) % BANKS;
+        }
+        return;
+    }
+
+    lcd.cmd_bytes++;
+    if ((BYTE & 0xF8) == 0x20)        // function set (PD, V, H)
+        lcd.extended = BYTE & 0x01;
+    else if (lcd.extended)            // bias, temperature coefficient and VOP do not change the picture
+        return;
+    else if (BYTE & 0x80)             // set X address
+        lcd.x = (BYTE & 0x7F) < LCD_CAPTURE_WIDTH ? (BYTE & 0x7F) : 0;
+    else if ((BYTE & 0xF8) == 0x40)   // set Y address
+        lcd.bank = (BYTE & 0x07) < BANKS ? (BYTE & 0x07) : 0;
+}
+
+/*
+ * The driver loads SPDR and then polls SPSR until the byte is out, so the
+ * byte is handed to the controller on the first SPSR access after the load,
+ * with the DC and SCE levels of that moment
+ */
+volatile uint8_t *host_spdr(void)
+{
+    loaded = 1;
+    return &spdr;
+}
+
+volatile uint8_t *host_spsr(void)
+{
+    if (loaded)
+    {
+        loaded = 0;
+        if (!(PORT_LCD & (1 << LCD_SCE)))
+            receive(spdr, (PORT_LCD & (1 << LCD_DC)) != 0);
+    }
+    spsr |= (1 << SPIF);
+    return &spsr;
+}
+
+void lcd_capture_reset()
+{
+    memset(&lcd, 0, sizeof(lcd));
+}
+
+uint8_t lcd_capture_pixel(const uint8_t x, const uint8_t y)
+{
+    return (lcd.ram[(y / 8) * LCD_CAPTURE_WIDTH + x] >> (y % 8)) & 1;
+}
+
+const uint8_t *lcd_capture_ram()
+{
+    return lcd.ram;
+}
+
+uint32_t lcd_capture_data_bytes()
+{
+    return lcd.data_bytes;
+}
+
+uint32_t lcd_capture_cmd_bytes()
+{
+    return lcd.cmd_bytes;
+}
+
+void lcd_capture_write_pbm(FILE *out)
+{
+    fprintf(out, "P1\n%d %d\n", LCD_CAPTURE_WIDTH, LCD_CAPTURE_HEIGHT);
+    for (uint8_t y = 0; y < LCD_CAPTURE_HEIGHT; y++)
+    {
+        for (uint8_t x = 0; x < LCD_CAPTURE_WIDTH; x++)
+            fputc(lcd_capture_pixel(x, y) ? '1' : '0', out);
+        fputc('\n', out);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef __LCD_CAPTURE_H__
+#define __LCD_CAPTURE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Model of the PCD8544 fed by the mocked SPI: the bytes the driver sends while SCE is low are decoded as commands or data
+ * (according to DC) into the display RAM, with horizontal addressing, like the real controller does.
+ */
+
+#define LCD_CAPTURE_WIDTH   84
+#define LCD_CAPTURE_HEIGHT  48
+
+/**
+ * Clears the display RAM, the address and the counters.
+ */
+void lcd_capture_reset();
+
+/**
+ * @param x horizontal position (0-83)
+ * @param y vertical position (0-47)
+ * @return 1 if the pixel is lit on the display, 0 otherwise
+ */
+uint8_t lcd_capture_pixel(const uint8_t x, const uint8_t y);
+
+/**
+ * @return the display RAM, 6 banks of 84 columns (504 bytes), in the same layout as the screen buffer of the driver
+ */
+const uint8_t *lcd_capture_ram();
+
+/**
+ * @return how many data bytes were sent since the last reset
+ */
+uint32_t lcd_capture_data_bytes();
+
+/**
+ * @return how many command bytes were sent since the last reset
+ */
+uint32_t lcd_capture_cmd_bytes();
+
+/**
+ * Writes the display as a plain PBM image (84x48, 1 - lit).
+ * @param out where the image is written
+ */
+void lcd_capture_write_pbm(FILE *out);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef __HOST_UTIL_ATOMIC_H__
+#define __HOST_UTIL_ATOMIC_H__
+
+/* There are no interruptions on the host, the block just runs once */
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type) for (uint8_t __done = 0; !__done; __done = 1)
+
+#endif
@@ -1,41 +1,173 @@
 #include <avr/interrupt.h>
-#include <stdio.h>
+#include <avr/sleep.h>
 #include <stdbool.h>
-#include <time.h>
-#include <math.h>
 #include "nokia5110.h"
+#include "ticks.h"
+#include "buttons.h"
+#include "sched.h"
+#include "telemetry.h"
+#include "prof.h"
+#include "fmt.h"
+#include "rng.h"
+#include "store.h"
+#include "fonts.h"
+#include "backgrounds.h"
+#include "anim.h"
+#include "sprites.h"
+#include "board.h"
+#include "moles.h"
+#include "stats.h"
 
-// VALUES THAT CAN BE SET BY THE USER
-/**
- * Constants for setting timer.
- */
-#define TIMER_CLK		F_CPU / 1024
-#define IRQ_FREQ		10                  // number of interruptions per second
+// VALUES THAT CAN BE SET BY THE USER (the timer is set up in ticks.h)
 /**
  * Durations
  */
 #define GAME_DURATION_SEC              60   // game duration, in seconds
 #define MAX_MISSES_IN_SEQ              15    // how many misses the user can have in a row
-float curr_appear_duration_sec       = 2.0; // how long the mole stays out of its whole
+#define APPEAR_DURATION_SEC            2.0   // how long the mole initially stays out of its whole (up to MOLES_LIFE_MAX ticks)
 #define APPEAR_DUR_REDUCTION_FACT      0.05  // each time the user hits the mole, the appear duration will reduce by this value
+#define IDLE_TIMEOUT_SEC               20    // how long the title and game over screens wait for a button before powering down
+/**
+ * Buttons of the screens out of the game
+ */
+#define START_BUTTON                   0     // W (BOARD_KEYS[0] on a keypad), on the title, starts a game with one mole
+#define MULTI_BUTTON                   2     // S (BOARD_KEYS[2]), on the title, starts a game with MULTI_MOLES moles out at once
+#define MULTI_MOLES                    3     // fewer than the wholes, so a mole that leaves its whole always finds another
+#define PROFILE_BUTTON                 4     // X (BOARD_KEYS[4]), on the game over screen, shows the profiler (PROFILE builds only)
+/**
+ * Task periods (the priority of each task is its position in the task table, in main())
+ */
+#define INPUT_PERIOD_MS                10    // the input task also runs as soon as a button event arrives
+#define GAME_PERIOD_MS                 10
+#define TABLE_PERIOD_MS                50    // the wholes are drawn at most 20 times per second (animations)
+#define FIELDS_PERIOD_MS               100   // the numbers change at most once a second (timer) or per hit or miss
+#define TELEMETRY_PERIOD_MS            1000
 
 // VALUES THAT SHOULD NOT BE CHANGED (DO NOT CHANGE!)
-float global_interruption_count = 0.0;                          // used for controlling when the game should end
-float appear_duration_count = 0.0;                              // used for controlling when the mole should change its whole
+/**
+ * Durations converted to Timer 1 ticks at compile time, so no floating point code ends up in the firmware. The appear duration
+ * is kept in Q8.8 (ticks * 256), as the reduction factor is a fraction of a tick.
+ */
+#define GAME_DURATION_TICKS            (GAME_DURATION_SEC * IRQ_FREQ)
+#define APPEAR_DURATION_Q8             ((uint16_t) (APPEAR_DURATION_SEC * IRQ_FREQ * 256))
+#define APPEAR_DUR_REDUCTION_Q8        ((uint16_t) (APPEAR_DUR_REDUCTION_FACT * IRQ_FREQ * 256))
+#define MIN_APPEAR_DURATION_Q8         (1 << 8) // the mole stays out for at least one tick
+#define IDLE_TIMEOUT_TICKS             (IDLE_TIMEOUT_SEC * IRQ_FREQ)
+#ifdef PROFILE
+#define GAME_OVER_BUTTONS              ((1 << START_BUTTON) | (1 << PROFILE_BUTTON))
+#else
+#define GAME_OVER_BUTTONS              (1 << START_BUTTON)
+#endif
+
+/**
+ * Game states. After the game over screen the game goes back to the title, so a new game can be played without a reset.
+ */
+enum game_state
+{
+    STATE_TITLE,      // initial screen, waiting for W
+    STATE_PLAYING,    // the game tasks are running
+    STATE_GAME_OVER,  // result screen, waiting for W (or X, for the profiler)
+    STATE_PROFILE     // profiler screen, waiting for W
+};
+
+uint16_t curr_appear_duration_q8 = APPEAR_DURATION_Q8;          // how long a mole stays out of its whole, in ticks (Q8.8)
 uint16_t points_counter = 0;                                    // counts how many times the player has hit the mole
-const float int_count_appear_dur_count_red_fact = 1.0/IRQ_FREQ; // every time an interruption is generated by the timer, global_interruption_count and appear_duration_count will reduce by this factor
+#define WHOLES_BUTTONS                 BOARD_WHOLES  // how many wholes and buttons there are in the game (BOARD, see board.h)
+#if MULTI_MOLES >= WHOLES_BUTTONS
+#error "MULTI_MOLES must be lower than the number of wholes"
+#endif
+// overlays of the game screen with LCD_TILES: the sprite of each whole, and each digit of the misses (2), time (2) and points
+// (up to 5, past its field) fields, which are off the grid of the tiles
+#define GAME_OVERLAYS                  (WHOLES_BUTTONS + 2 + 2 + FMT_U16_DIGITS)
+#if defined(LCD_TILES) && NOKIA_LCD_OVERLAYS < GAME_OVERLAYS
+#error "NOKIA_LCD_OVERLAYS cannot hold the game screen (see the Makefile)"
+#endif
+uint8_t moles_count = 1;                                        // how many moles are out at once (1 or MULTI_MOLES)
+uint16_t moles_ticked = 0;                                      // tick up to which the lifetimes of the moles were counted down
+struct anim_player wholes[WHOLES_BUTTONS];                      // what each whole is showing
+uint32_t appear_stamps[WHOLES_BUTTONS];                         // ticks_stamp() when the mole of each whole was first sent to the LCD
+whole_mask_t unseen = 0;                                        // wholes whose mole popped up but was not sent to the LCD yet
+struct stats reactions;                                         // time from a mole on the LCD to the press that hit it
+uint8_t misses_sequence = 0;                                    // how many misses the user has made in a row
+uint16_t misses_counter = 0;                                    // counts all the misses of the game
+uint16_t shown_second = 0;                                      // the seconds on the screen
+bool table_redraw = true;                                       // whether the wholes have changes that were not rendered yet
+bool fields_redraw = true;                                      // whether the numbers have changes that were not rendered yet
+uint8_t cpu_load = 0;                                           // how much of the last second the MCU was awake, in percent
+uint8_t cpu_load_peak = 0;                                      // highest cpu_load of the game
+uint16_t frame_counts_max = 0;                                  // longest frame of the last second, in Timer 1 counts
+uint16_t frame_bytes = 0;                                       // bytes sent to the LCD in the last second
+struct fmt_field misses_field = { 67, 25, 2, 1 };               // the numbers of the game screen
+struct fmt_field time_field = { 39, 41, 2, 0 };
+struct fmt_field points_field = { 57, 41, 3, 1 };
+
+/**
+ * Plays one game: resets the game variables and the game time, and runs the game tasks until the time is up or the user misses
+ * too many times in a row.
+ */
+void play();
+
+/**
+ * Waits for one of the buttons to be pressed, ignoring the buttons pressed before the call. If no button is pressed for
+ * IDLE_TIMEOUT_SEC, the LCD and the MCU are powered down until a button wakes them up.
+ * @param BUTTONS the buttons that are waited for (bit i set: button i)
+ * @return the press event
+ */
+struct button_event wait_for_press(const buttons_mask_t BUTTONS);
+
+/**
+ * Input task: handles the button presses since its last run, in the order they happened. Runs as soon as an event arrives.
+ */
+void task_input();
+
+/**
+ * Game task: ends the game and moves the mole when its time is up.
+ */
+void task_game();
+
+/**
+ * Table render task: draws the frames of the animations that are due and sends the areas of the wholes to the LCD.
+ */
+void task_render_table();
+
+/**
+ * Fields render task: draws the numbers that changed and sends their areas of the screen to the LCD.
+ */
+void task_render_fields();
+
+/**
+ * Telemetry task: measures how much of the last second the MCU was awake and sends the performance counters of the last second.
+ */
+void task_telemetry();
+
+/**
+ * Draws the initial screen, with the score table.
+ */
+void render_title();
 
 /**
- * Initiates/resets Timer 1.
+ * Loads the parts of the game screen that never change (the misses box, the labels and the divider), pre-rendered in
+ * backgrounds.txt, and sends them. The other render functions only overwrite and send their own areas, so the LCD driver only
+ * sends what actually changed, each area when it changes.
  */
-void timer1_init();
+void render_layout();
 
 /**
- * Renders the table, drawing, for each of the five wholes, the character specified in the array passed as parameter.
- * @param WHOLE the whole where the mole should be drawn
+ * Renders the table, drawing the frame of the animation of each whole that is due, if it is not on the screen yet.
+ * @param NOW the current tick
  * @param NWHOLES the number of wholes in the game
+ * @return true if any animation is still running, so the table must be rendered again
+ */
+bool render_table(const uint16_t NOW, const uint8_t NWHOLES);
+
+/**
+ * Moves a mole to a new random whole: the mole leaves its whole with the given animation and pops up from a whole that is
+ * neither its own nor one with a mole out.
+ * @param WHOLE the whole of the mole
+ * @param AVOID other wholes the mole must not pop up from (e.g. wholes that are about to be moved from too)
+ * @param LEAVE how the mole leaves its whole (whacked or retreating)
  */
-void render_table(const uint8_t WHOLE, const uint8_t NWHOLES);
+void move_mole(const uint8_t WHOLE, const whole_mask_t AVOID, const struct anim *LEAVE);
 
 /**
  * Renders the timer, the points and how many times the user has missed the mole in a row.
@@ -44,207 +176,509 @@ void render_table(const uint8_t WHOLE, const uint8_t NWHOLES);
 void render_timer_points_misses(const uint8_t MISSES_IN_ROW);
 
 /**
- * This method ends the game by displaying the message "GAME OVER", how many points the user has scored and then enters in an infinite loop
- * while the messages are kept on the screen.
+ * Draws the profiler screen: the average and the longest time of each probe, in microseconds. Empty if the profiler is not
+ * built (PROFILE).
+ */
+void render_profile();
+
+/**
+ * This method ends the game by displaying the message "GAME OVER", how many points the user has scored, the statistics of the
+ * reaction times of the hits and how much of the game the MCU was awake, and saves the game in the EEPROM.
  */
 void game_over();
 
 /**
- * Randomly selects a new whole for the mole to appear, making sure the new whole is different from the previous.
- * @param CURRENT_WHOLE the current whole where the mole is
+ * Randomly selects a new whole for a mole to appear, making sure the new whole is not one of the given ones.
+ * @param TAKEN the wholes that cannot be picked (the mole's current whole and the wholes with a mole out)
  * @param NWHOLES the number of wholes in the game
- * @return the new whole randomly picked, which necessarily is different from the 'CURRENT_WHOLE' parameter
+ * @return the new whole randomly picked, which necessarily is not in the 'TAKEN' parameter
  */
-uint8_t new_rand_whole(const uint8_t CURRENT_WHOLE, const uint8_t NWHOLES);
+uint8_t new_rand_whole(const whole_mask_t TAKEN, const uint8_t NWHOLES);
 
 /**
- * Interruption routine for Timer 1.
+ * Whether the MCU must not power down: a debounce window is open or the keypad is being scanned (Timer 2 stops in power-down),
+ * or the EEPROM is being written (its interruption cannot wake the MCU up).
+ * @return 1 if the MCU must stay awake, 0 otherwise
  */
-ISR(TIMER1_COMPA_vect)
-{
-    global_interruption_count += int_count_appear_dur_count_red_fact;
-    appear_duration_count += int_count_appear_dur_count_red_fact;
-    if (global_interruption_count >= GAME_DURATION_SEC)
-        game_over();
-}
+uint8_t clocks_busy();
 
 int main()
 {
     cli();                                                                        // disable interruptions
+#ifdef KEYPAD
+    DDRC |= ((1 << PC5) | (1 << PC4) | (1 << PC3)) & ~BUTTONS_ROWS;               // PC5 to PC3 -> output, but the keypad rows
+#else
     DDRC |= (1 << PC5) | (1 << PC4) | (1 << PC3);                                 // PC5 to PC3 -> output
-    DDRD &= ~(1 << PD4) & ~(1 << PD3) & ~(1 << PD2) & ~(1 << PD1) & ~(1 << PD0);  // PD4 to PD0 -> input
-    PORTD |= (1 << PD4) | (1 << PD3) | (1 << PD2) | (1 << PD1) | (1 << PD0);      // enabling internal pull-up
+#endif
+    buttons_init();                                                               // button pins (see buttons.h) and their interruptions
+    telemetry_init();                                                             // PD1 -> USART TX, if the telemetry is on
+    sched_set_pending(buttons_pending);                                           // a button event ends any sleep
+    sched_set_busy(clocks_busy);                                                  // Timer 2 or the EEPROM keep it out of power-down
 
     // setting up the LCD
     nokia_lcd_init();
-    nokia_lcd_clear();
 
     timer1_init();
+    rng_seed_adc();
+    store_init();   // scores and statistics of the previous games
+    sei();          // enable interruptions (the buttons are read by interruption routines)
 
-    // INITIAL SCREEN:
-    nokia_lcd_drawrect(0, 0, 83, 47);
-    nokia_lcd_set_cursor(7, 10);
-    nokia_lcd_write_string("WHAC-A-MOLE!", 1);
-    nokia_lcd_set_cursor(6, 20);
-    nokia_lcd_write_string("(W to start)", 1);
-    nokia_lcd_set_cursor(5, 35);
-    char time[14];
-    sprintf(time, "You have %ds", GAME_DURATION_SEC);
-    nokia_lcd_write_string(time, 1);
-    nokia_lcd_render();
-    unsigned int seed = 0;                                           // seed generated by iterations
-    while (((PIND & (1 << PD0)) != 0))                               // while button has not been presssed, display the initial screen and "generate" seed
-        seed++;
-    while ((PIND & (1 << PD0)) == 0);                                // once the button has been pressed, wait for button release
-
-    srand(seed); // set the seed
-    sei();       // enable interruptions
-
-    // GAME LOGIC
-    const uint8_t WHOLES_BUTTONS = 5;             // how many wholes and buttons there are in the game
-    uint8_t rand_whole = rand() % WHOLES_BUTTONS; // stores the current whole where the mole is
-    uint8_t misses_sequence = 0;                  // how many misses the user has made in a row
+    enum game_state state = STATE_TITLE;
+    struct button_event event;
     while (1)
     {
-        render_timer_points_misses(misses_sequence);
+        switch (state)
+        {
+        case STATE_TITLE:
+            render_title();
+            event = wait_for_press((1 << START_BUTTON) | (1 << MULTI_BUTTON));
+            moles_count = event.button == MULTI_BUTTON ? MULTI_MOLES : 1;
+            rng_seed(event.time); // also mixed into the seed: how long it took the player to press W, in Timer 1 counts
+            state = STATE_PLAYING;
+            break;
+
+        case STATE_PLAYING:
+            play();
+            state = STATE_GAME_OVER;
+            break;
+
+        case STATE_GAME_OVER:
+            game_over();
+            prof_dump();
+            event = wait_for_press(GAME_OVER_BUTTONS);
+            state = event.button == START_BUTTON ? STATE_TITLE : STATE_PROFILE;
+            break;
+
+        case STATE_PROFILE:
+            render_profile();
+            wait_for_press(1 << START_BUTTON);
+            state = STATE_TITLE;
+            break;
+        }
+    }
+}
 
-        if (appear_duration_count >= curr_appear_duration_sec) // if APPEAR_DURATION_SEC have passed, change the whole where the mole should be
+void play()
+{
+    points_counter = 0;
+    misses_sequence = 0;
+    misses_counter = 0;
+    curr_appear_duration_q8 = APPEAR_DURATION_Q8;
+    shown_second = 0;
+    table_redraw = fields_redraw = true;
+    cpu_load = cpu_load_peak = 0;
+    frame_counts_max = frame_bytes = 0;
+    prof_reset();
+    stats_reset(&reactions);
+
+    timer1_init();     // the game time starts now
+    render_layout();
+
+    moles_reset();
+    moles_ticked = 0;
+    unseen = 0;
+    for (uint8_t i = 0; i < WHOLES_BUTTONS; i++)
+        anim_play(&wholes[i], &MOLE_HOLE, 0);
+    for (uint8_t i = 0; i < moles_count; i++)
+    {
+        uint8_t whole = new_rand_whole(moles_up, WHOLES_BUTTONS);
+        moles_pop(whole, curr_appear_duration_q8 >> 8);
+        unseen |= (whole_mask_t) 1 << whole;
+        anim_play(&wholes[whole], &MOLE_POPUP, 0);
+    }
+    struct sched_task tasks[] =   // in priority order
+    {
+        { task_input,     buttons_pending, MS_TO_TICKS(INPUT_PERIOD_MS) },
+        { task_game,      NULL,            MS_TO_TICKS(GAME_PERIOD_MS) },
+        { task_render_table,  NULL,        MS_TO_TICKS(TABLE_PERIOD_MS) },
+        { task_render_fields, NULL,        MS_TO_TICKS(FIELDS_PERIOD_MS) },
+        { task_telemetry, NULL,            MS_TO_TICKS(TELEMETRY_PERIOD_MS) },
+    };
+    sched_run(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    nokia_lcd_flush(); // the last frame of the game must be out before the next screen is drawn
+
+    // how close each task came to its period during the game
+    for (uint8_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++)
+    {
+        uint8_t task[] =
         {
-            misses_sequence++;
-            rand_whole = new_rand_whole(rand_whole, WHOLES_BUTTONS);
+            i,
+            tasks[i].max_runtime & 0xFF, tasks[i].max_runtime >> 8,
+            tasks[i].overruns & 0xFF, tasks[i].overruns >> 8
+        };
+        telemetry_send(TELEMETRY_TASK, task, sizeof(task));
+    }
+}
+
+struct button_event wait_for_press(const buttons_mask_t BUTTONS)
+{
+    struct button_event event;
+    while (buttons_get(&event)); // presses made before the screen was shown do not count
+
+    uint16_t idle_since = ticks_now();
+    while (1)
+    {
+        while (buttons_get(&event))
+        {
+            if (event.pressed && (BUTTONS & ((buttons_mask_t) 1 << event.button)))
+                return event;
+            idle_since = ticks_now();
         }
-        render_table(rand_whole, WHOLES_BUTTONS);
 
-        // check which buttons are pressed
-        bool pressed[WHOLES_BUTTONS];
-        for (int i=0; i<WHOLES_BUTTONS; i++) // initialize all buttons as not pressed
-            pressed[i] = false;
-        for (int i=0; i<WHOLES_BUTTONS; i++) // iterate over all buttons and get the first pressed button
+        uint16_t now = ticks_now();
+        if ((uint16_t) (now - idle_since) < IDLE_TIMEOUT_TICKS || buttons_busy())
         {
-            if ((PIND & (1 << i)) == 0)       // if button is pressed
-            {
-                while((PIND & (1 << i)) == 0) // wait button release, but keep rendering the points and table
-                {
-                    render_timer_points_misses(misses_sequence);
-                    render_table(rand_whole, WHOLES_BUTTONS);
-                }
-                pressed[i] = true;
-                break;
-            }
+            sched_sleep(now);
+            continue;
         }
-        
-        if (pressed[rand_whole]) // hit (increment points_counter and get new random whole)
+
+        // nothing happened for a while: the LCD and the MCU are powered down until a button is pressed
+        nokia_lcd_flush();
+        nokia_lcd_power(0);
+        sched_power_down();
+        nokia_lcd_power(1);
+        nokia_lcd_invalidate(); // the display RAM may have lost the screen while powered down
+        nokia_lcd_render();
+        idle_since = ticks_now();
+    }
+}
+
+void task_input()
+{
+    struct button_event event;
+    while (buttons_get(&event))
+    {
+        if (!event.pressed || event.button >= WHOLES_BUTTONS) // releases are ignored
+            continue;
+
+        if (moles_up & ((whole_mask_t) 1 << event.button)) // hit (increment points_counter and get new random whole)
         {
             points_counter++;
+            fields_redraw = true;
+            // reaction time: from the first frame of the mole sent to the LCD to the first edge of the press, in Timer 1
+            // counts (4 us); a press that began before the mole was on the screen is no reaction
+            uint32_t reaction = event.time - appear_stamps[event.button];
+            if (!(unseen >> event.button & 1) && reaction < 0x80000000)
+                stats_add(&reactions, COUNTS_TO_US(reaction));
+            uint8_t hit[] = { event.button, points_counter & 0xFF, points_counter >> 8 };
+            telemetry_send(TELEMETRY_HIT, hit, sizeof(hit));
             misses_sequence = 0;
-            curr_appear_duration_sec -= APPEAR_DUR_REDUCTION_FACT;
-            if (curr_appear_duration_sec < 1/IRQ_FREQ) curr_appear_duration_sec = 1/IRQ_FREQ;
-            rand_whole = new_rand_whole(rand_whole, WHOLES_BUTTONS);
+            if (curr_appear_duration_q8 >= MIN_APPEAR_DURATION_Q8 + APPEAR_DUR_REDUCTION_Q8)
+                curr_appear_duration_q8 -= APPEAR_DUR_REDUCTION_Q8;
+            else
+                curr_appear_duration_q8 = MIN_APPEAR_DURATION_Q8;
         }
-        else                     // the user either did not try to hit the mole or missed it (guessed)
+        else                                // the user took a guess and missed, get new random wholes for all the moles
         {
-            // iterate over all buttons to check if the user guessed a whole
-            for (int i=0; i<WHOLES_BUTTONS; i++)
+            misses_sequence++;
+            misses_counter++;
+            fields_redraw = true;
+            uint8_t miss[] = { event.button, misses_sequence };
+            telemetry_send(TELEMETRY_MISS, miss, sizeof(miss));
+            for (whole_mask_t up = moles_up, i = 0; up; up >>= 1, i++)
+                if (up & 1)
+                    move_mole(i, 0, &MOLE_RETREAT);
+            continue;
+        }
+        move_mole(event.button, 0, &MOLE_WHACKED);
+    }
+}
+
+void task_game()
+{
+    uint16_t now = ticks_now();
+    if (now >= GAME_DURATION_TICKS || misses_sequence >= MAX_MISSES_IN_SEQ)
+    {
+        sched_stop();
+        return;
+    }
+
+    if (now / IRQ_FREQ != shown_second) // the seconds on the screen changed
+    {
+        shown_second = now / IRQ_FREQ;
+        fields_redraw = true;
+        uint8_t left = GAME_DURATION_SEC - shown_second;
+        telemetry_send(TELEMETRY_TICK, &left, 1);
+    }
+
+    // the lifetimes of all the moles are counted down once per tick, also for the ticks the task ran late for; each mole whose
+    // appear duration has passed is moved to another whole
+    for (; moles_ticked != now; moles_ticked++)
+    {
+        whole_mask_t gone = moles_tick();
+        for (uint8_t i = 0; gone; i++)
+            if (gone >> i & 1)
             {
-                if (pressed[i]) // the user took a guess and missed, get new random whole
-                {
-                    misses_sequence++;
-                    rand_whole = new_rand_whole(rand_whole, WHOLES_BUTTONS);
-                    break;
-                }
+                gone &= ~((whole_mask_t) 1 << i);
+                misses_sequence++;
+                misses_counter++;
+                fields_redraw = true;
+                uint8_t miss[] = { TELEMETRY_TIMEOUT, misses_sequence };
+                telemetry_send(TELEMETRY_MISS, miss, sizeof(miss));
+                move_mole(i, gone, &MOLE_RETREAT); // not into the wholes still to be moved from
             }
+    }
+}
+
+void move_mole(const uint8_t WHOLE, const whole_mask_t AVOID, const struct anim *LEAVE)
+{
+    uint16_t now = ticks_now();
+    anim_play(&wholes[WHOLE], LEAVE, now);
+    moles_hide(WHOLE);
+    uint8_t whole = new_rand_whole(moles_up | AVOID | ((whole_mask_t) 1 << WHOLE), WHOLES_BUTTONS);
+    moles_pop(whole, curr_appear_duration_q8 >> 8);
+    unseen = (unseen & ~((whole_mask_t) 1 << WHOLE)) | (whole_mask_t) 1 << whole;
+    anim_play(&wholes[whole], &MOLE_POPUP, now);
+    telemetry_send(TELEMETRY_MOVE, &whole, 1);
+    table_redraw = true;
+}
+
+/**
+ * Accounts for an area rendered by a render task.
+ * @param START when the task started, from ticks_stamp()
+ * @param BYTES bytes sent to the LCD
+ */
+static void count_frame(const uint32_t START, const uint16_t BYTES)
+{
+    uint32_t counts = ticks_stamp() - START;
+    if (counts > frame_counts_max)
+        frame_counts_max = counts > 0xFFFF ? 0xFFFF : counts;
+    frame_bytes += BYTES;
+}
+
+void task_render_table()
+{
+    if (!table_redraw)
+        return;
+
+    uint32_t start = ticks_stamp();
+    uint16_t bytes = 0;
+    table_redraw = render_table(ticks_now(), WHOLES_BUTTONS); // drawn again while an animation runs
+    {
+        PROF_SCOPE(PROF_LCD_RENDER);
+#ifdef LCD_ASYNC
+        // one frame sent in background for the whole board (a rectangle per whole would wait for the previous one): the
+        // screen between the wholes never changes, so only the columns from the first to the last whole that changed are
+        // sent in each bank
+        nokia_lcd_render_rect(BOARD_X0, BOARD_Y0, (BOARD_COLS - 1) * BOARD_DX + MOLE.width, (BOARD_ROWS - 1) * BOARD_DY + 8);
+        bytes += nokia_lcd_frame_bytes();
+#endif
+        for (uint8_t i = 0; i < WHOLES_BUTTONS; i++)
+        {
+#ifndef LCD_ASYNC
+            // each whole is sent on its own, the screen between them never changes
+            nokia_lcd_render_rect(wholes[i].x, wholes[i].y, MOLE.width, 8);
+            bytes += nokia_lcd_frame_bytes();
+#endif
+            // the first frame of a mole that popped up is on the screen now (with LCD_ASYNC, its bytes are on their way)
+            if (unseen >> i & 1)
+                appear_stamps[i] = ticks_stamp();
         }
+        unseen = 0;
+    }
+    count_frame(start, bytes);
+}
 
-        if (misses_sequence == MAX_MISSES_IN_SEQ)
-            game_over();
+void task_render_fields()
+{
+    if (!fields_redraw)
+        return;
+
+    uint32_t start = ticks_stamp();
+    uint16_t bytes;
+    render_timer_points_misses(misses_sequence);
+    fields_redraw = false;
+    {
+        PROF_SCOPE(PROF_LCD_RENDER);
+        nokia_lcd_render_rect(misses_field.x, misses_field.y, misses_field.width * FMT_CHAR_WIDTH, 7);
+        bytes = nokia_lcd_frame_bytes();
+        // the timer and the points share the bottom line
+        nokia_lcd_render_rect(time_field.x, time_field.y,
+                              points_field.x + points_field.width * FMT_CHAR_WIDTH - time_field.x, 7);
+        bytes += nokia_lcd_frame_bytes();
+    }
+    count_frame(start, bytes);
+}
+
+void task_telemetry()
+{
+    static uint32_t last_stamp = 0, last_awake = 0, last_loops = 0;
+
+    uint32_t stamp = ticks_stamp();
+    uint32_t awake = sched_awake();
+    uint32_t loops = sched_loops();
+    if (awake < last_awake) // the scheduler has been restarted
+        last_stamp = last_awake = last_loops = 0;
+    if (stamp != last_stamp)
+        cpu_load = (awake - last_awake) * 100 / (stamp - last_stamp);
+    if (cpu_load > cpu_load_peak)
+        cpu_load_peak = cpu_load;
+
+    uint16_t loops_per_second = loops - last_loops;
+    uint8_t perf[] =
+    {
+        frame_counts_max & 0xFF, frame_counts_max >> 8,
+        frame_bytes & 0xFF, frame_bytes >> 8,
+        loops_per_second & 0xFF, loops_per_second >> 8,
+        cpu_load
+    };
+    telemetry_send(TELEMETRY_PERF, perf, sizeof(perf));
+    frame_counts_max = frame_bytes = 0;
+
+    last_stamp = stamp;
+    last_awake = awake;
+    last_loops = loops;
+}
+
+uint8_t new_rand_whole(const whole_mask_t TAKEN, const uint8_t NWHOLES)
+{
+    // one of the free wholes is picked by its position among them, no retries
+    uint8_t free = NWHOLES;
+    for (whole_mask_t taken = TAKEN; taken; taken &= taken - 1)
+        free--;
+    uint8_t pick = rng_below(free);
+    uint8_t whole = 0;
+    while ((TAKEN >> whole & 1) || pick--)
+        whole++;
+    return whole;
+}
+
+void render_title()
+{
+    nokia_lcd_load_P(BG_TITLE); // border, name and instructions
+    char line[] = "You have ?????s";
+    char *time = line + sizeof("You have ") - 1;
+    uint8_t digits = fmt_u16(time, GAME_DURATION_SEC);
+    time[digits] = 's';
+    time[digits + 1] = '\0';
+    nokia_lcd_write_string_centered(line, 36, &FONT_SMALL);
+    char modes[] = "W/S: 1/? moles";
+    modes[0] = BOARD_KEYS[START_BUTTON];
+    modes[2] = BOARD_KEYS[MULTI_BUTTON];
+    modes[sizeof("W/S: 1/") - 1] = '0' + MULTI_MOLES; // a single digit (at most 9)
+    nokia_lcd_write_string_centered(modes, 15, &FONT_SMALL);
+
+    // the score table, saved in the EEPROM
+    const struct store_stats *stats = store_get();
+    char best[sizeof("Best:") + STORE_SCORES * (FMT_U16_DIGITS + 1)] = "Best:";
+    char *end = best + sizeof("Best:") - 1;
+    for (uint8_t i = 0; i < STORE_SCORES && stats->scores[i]; i++)
+    {
+        *end++ = ' ';
+        end += fmt_u16(end, stats->scores[i]);
     }
+    if (stats->scores[0])
+        nokia_lcd_write_string_centered(best, 26, &FONT_SMALL);
+    nokia_lcd_render();
 }
 
-uint8_t new_rand_whole(const uint8_t CURRENT_WHOLE, const uint8_t NWHOLES)
+void render_layout()
 {
-    uint8_t randn;
-    do 
+    nokia_lcd_load_P(BG_GAME);
+
+    // the numbers were erased, they must be drawn whole
+    fmt_field_reset(&misses_field);
+    fmt_field_reset(&time_field);
+    fmt_field_reset(&points_field);
+    for (uint8_t i = 0; i < WHOLES_BUTTONS; i++)
     {
-        randn = rand() % NWHOLES;
-    } while (randn == CURRENT_WHOLE);
-    appear_duration_count = 0;
-    
-    return randn;
+        wholes[i].x = pgm_read_byte(&BOARD_LAYOUT[i].x);
+        wholes[i].y = pgm_read_byte(&BOARD_LAYOUT[i].y);
+        anim_reset(&wholes[i]);
+    }
+    nokia_lcd_render(); // from now on each area is sent by its own render task
 }
 
 void render_timer_points_misses(const uint8_t MISSES_IN_ROW)
+{
+    PROF_SCOPE(PROF_RENDER_FIELDS);
+
+    // fixed width fields: the padding erases the previous value, and only the characters that changed are drawn
+    fmt_field_draw(&misses_field, MISSES_IN_ROW);
+    fmt_field_draw(&time_field, GAME_DURATION_SEC - ticks_now() / IRQ_FREQ);
+    fmt_field_draw(&points_field, points_counter);
+}
+
+bool render_table(const uint16_t NOW, const uint8_t NWHOLES)
+{
+    PROF_SCOPE(PROF_RENDER_TABLE);
+
+    bool animating = false;
+    for (uint8_t i = 0; i < NWHOLES; i++)
+        animating |= anim_draw(&wholes[i], NOW);
+    return animating;
+}
+
+void render_profile()
 {
     nokia_lcd_clear();
-    
-    // render misses
-    nokia_lcd_drawrect(52, 22, 82, 35);
-    nokia_lcd_set_cursor(55, 25);
-    nokia_lcd_write_string("M:", 1);
-    char misses[4];
-    sprintf(misses, "%d", MISSES_IN_ROW);
-    nokia_lcd_write_string(misses, 1);
-
-    // render times/points
-    nokia_lcd_set_cursor(0, 41);
-    nokia_lcd_write_string("T/Pts: ", 1);
-    char t_pts[10];
-    sprintf(t_pts, "%d/%d", GAME_DURATION_SEC-(int) global_interruption_count, points_counter);
-    nokia_lcd_set_cursor(39, 41);
-    nokia_lcd_write_string(t_pts, 1);
-}
-
-void render_table(const uint8_t WHOLE, const uint8_t NWHOLES)
-{
-    char whole_symbols[NWHOLES];
-    for(int i=0; i<NWHOLES; i++)
-        whole_symbols[i] = 'O';
-    
-    whole_symbols[WHOLE] = '&';
-
-    nokia_lcd_set_cursor(37, 0);
-    nokia_lcd_write_char(whole_symbols[0], 1);
-    nokia_lcd_set_cursor(0, 13);
-    nokia_lcd_write_char(whole_symbols[1], 1);
-    nokia_lcd_set_cursor(37, 13);
-    nokia_lcd_write_char(whole_symbols[2], 1);
-    nokia_lcd_set_cursor(72, 13);
-    nokia_lcd_write_char(whole_symbols[3], 1);
-    nokia_lcd_set_cursor(37, 28);
-    nokia_lcd_write_char(whole_symbols[4], 1);
-    nokia_lcd_drawline(0, 38, 84, 38); // divider
+    nokia_lcd_set_cursor(0, 0);
+    nokia_lcd_write_string("PROFILE (us)", 1);
+    nokia_lcd_set_cursor(0, 8);
+    nokia_lcd_write_string("     avg   max", 1);
+#ifdef PROFILE
+    for (uint8_t i = 0; i < PROF_COUNT; i++)
+    {
+        const struct prof_stat *stat = prof_get(i);
+        char name[4];
+        memcpy_P(name, prof_name(i), sizeof(name));
+        nokia_lcd_set_cursor(0, 16 + 8 * i);
+        nokia_lcd_write_string(name, 1);
+
+        // probes are shorter than a tick, so the times fit in 16 bits
+        struct fmt_field avg = { 3 * FMT_CHAR_WIDTH, 16 + 8 * i, 5, 0 };
+        struct fmt_field max = { 9 * FMT_CHAR_WIDTH, 16 + 8 * i, 5, 0 };
+        fmt_field_draw(&avg, stat->count ? COUNTS_TO_US(stat->sum / stat->count) : 0);
+        fmt_field_draw(&max, COUNTS_TO_US(stat->max));
+    }
+#endif
     nokia_lcd_render();
 }
 
 void game_over()
 {
-    nokia_lcd_clear();
-    nokia_lcd_set_cursor(20, 0);
-    nokia_lcd_write_string("GAME", 2);
-    nokia_lcd_set_cursor(20, 20);
-    nokia_lcd_write_string("OVER", 2);
+    nokia_lcd_load_P(BG_GAME_OVER); // "GAME OVER", the points label and the labels of the reaction times
+
+    // how long the MCU was awake during the game and how many times it woke up, in the small font: "CPU:100% W:65535" is
+    // 84 pixels wide at most, and the proportional font is clipped at the right edge instead of wrapping over the title
+    uint32_t total_counts = ticks_stamp();
+    char number[FMT_U16_DIGITS + 1];
     nokia_lcd_set_cursor(0, 40);
-    nokia_lcd_write_string("Points: ", 1);
-    char points[17];
-    sprintf(points, "%d", points_counter);
-    nokia_lcd_set_cursor(45, 40);
-    nokia_lcd_write_string(points, 1);
-    nokia_lcd_render();
+    nokia_lcd_write_string_font("CPU:", &FONT_SMALL);
+    fmt_u16(number, total_counts ? sched_awake() * 100 / total_counts : 100);
+    nokia_lcd_write_string_font(number, &FONT_SMALL);
+    nokia_lcd_write_string_font("% W:", &FONT_SMALL);
+    fmt_u16(number, sched_wakes());
+    nokia_lcd_write_string_font(number, &FONT_SMALL);
 
-    while (1);
+    // reaction times of the hits in milliseconds, two per line after their labels
+    const uint32_t TIMES[] =
+    {
+        stats_mean(&reactions), stats_sd(&reactions),
+        stats_quantile(&reactions, 50), stats_quantile(&reactions, 90),
+        stats_min(&reactions), stats_max(&reactions)
+    };
+    for (uint8_t i = 0; i < sizeof(TIMES) / sizeof(TIMES[0]); i++)
+    {
+        struct fmt_field time = { i & 1 ? 60 : 18, 16 + 8 * (i / 2), 4, 0 };
+        fmt_field_draw(&time, (TIMES[i] + 500) / 1000);
+    }
+
+    fmt_u16(number, points_counter);
+    nokia_lcd_set_cursor(45, 8);
+    nokia_lcd_write_string(number, 1);
+
+    // saved in background; a place in the score table is shown after the points
+    uint8_t rank = store_add_game(points_counter, misses_counter);
+    if (rank < STORE_SCORES)
+    {
+        nokia_lcd_write_string(" #", 1);
+        nokia_lcd_write_char('1' + rank, 1);
+    }
+    nokia_lcd_render();
 }
 
-void timer1_init()
+uint8_t clocks_busy()
 {
-	// resets counters for Timer 1
-	TCCR1A = 0;
-	TCCR1B = 0;
-	TCNT1  = 0;
-	// sets register output compare
-	OCR1A = (TIMER_CLK / IRQ_FREQ) - 1;
-	// sets TCT mode
-	TCCR1B |= (1 << WGM12);
-	// sets CS10 and CS12 for 1024 prescaler
-	TCCR1B |= (1 << CS12) | (1 << CS10);  
-	// enables timer1 mask
-	TIMSK1 |= (1 << OCIE1A);
-}
\ No newline at end of file
+    return buttons_busy() || store_busy();
+}
@@ -0,0 +1,40 @@
+#include "moles.h"
+
+whole_mask_t moles_up = 0;
+static whole_mask_t life[MOLES_LIFE_BITS];  // bit i of the countdown of each whole; a mole goes back in when its countdown goes below 0
+
+void moles_reset()
+{
+    moles_up = 0;
+}
+
+void moles_pop(const uint8_t WHOLE, const uint16_t TICKS)
+{
+    const whole_mask_t BIT = (whole_mask_t) 1 << WHOLE;
+    uint16_t count = TICKS - 1;
+    for (uint8_t i = 0; i < MOLES_LIFE_BITS; i++, count >>= 1)
+        life[i] = count & 1 ? life[i] | BIT : life[i] & ~BIT;
+    moles_up |= BIT;
+}
+
+void moles_hide(const uint8_t WHOLE)
+{
+    moles_up &= ~((whole_mask_t) 1 << WHOLE);
+}
+
+whole_mask_t moles_tick()
+{
+    // 1 is subtracted from all the countdowns at once, the borrow rippling from the lowest bit up; it stops as soon as no
+    // countdown borrows any more
+    whole_mask_t borrow = moles_up;
+    for (uint8_t i = 0; i < MOLES_LIFE_BITS && borrow; i++)
+    {
+        const whole_mask_t BITS = life[i];
+        life[i] = BITS ^ borrow;
+        borrow &= ~BITS;
+    }
+
+    // the borrow out of the highest bit: the countdowns that were at 0
+    moles_up &= ~borrow;
+    return borrow;
+}
@@ -0,0 +1,50 @@
+#ifndef __MOLES_H__
+#define __MOLES_H__
+
+#include <stdint.h>
+#include "board.h"
+
+/**
+ * The moles out of their wholes, any number of them at once, each with its own lifetime. The lifetimes are countdowns kept
+ * bit-sliced: bit i of the counters of all the wholes is stored together in one whole mask, so one tick decrements every counter
+ * with MOLES_LIFE_BITS mask operations, however many wholes and moles there are.
+ */
+
+#if BOARD_WHOLES > 8
+typedef uint16_t whole_mask_t;                    // one bit per whole (bit i: whole i)
+#else
+typedef uint8_t whole_mask_t;
+#endif
+#define MOLES_LIFE_BITS   8                       // bits of each countdown
+#define MOLES_LIFE_MAX    (1 << MOLES_LIFE_BITS)  // longest lifetime, in ticks
+
+/**
+ * The wholes with a mole out (bit i set: whole i).
+ */
+extern whole_mask_t moles_up;
+
+/**
+ * Sends all the moles back in.
+ */
+void moles_reset();
+
+/**
+ * A mole comes out of a whole, for a given number of ticks.
+ * @param WHOLE the whole (with no mole out)
+ * @param TICKS how long the mole stays out (1 to MOLES_LIFE_MAX)
+ */
+void moles_pop(const uint8_t WHOLE, const uint16_t TICKS);
+
+/**
+ * The mole of a whole goes back in before its time is up (it was whacked).
+ * @param WHOLE the whole
+ */
+void moles_hide(const uint8_t WHOLE);
+
+/**
+ * Counts one tick down from the lifetime of every mole out, and sends back in the moles whose time is up.
+ * @return the wholes whose mole went back in
+ */
+whole_mask_t moles_tick();
+
+#endif
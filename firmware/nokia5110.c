@@ -15,46 +15,490 @@
 
 #include <avr/pgmspace.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
 #include <string.h>
 #include "nokia5110_chars.h"
 
+#ifdef LCD_TILES
+/*
+ * Display list entry: a drawing call recorded with its arguments, replayed
+ * into each bank at render
+ */
+struct overlay
+{
+    uint8_t kind;
+
+    /* corners, ends or center and radius; text: offset and length in text[] */
+    uint8_t x1, y1, x2, y2;
+
+    /* pixel or fill value, sprite frame, text scale (0 with a font) */
+    uint8_t value;
+
+    /* sprite or font */
+    const void *data;
+};
+
+enum
+{
+    OVERLAY_PIXEL,
+    OVERLAY_FILL,
+    OVERLAY_LINE,
+    OVERLAY_CIRCLE,
+    OVERLAY_SPRITE,
+    OVERLAY_TEXT
+};
+
+#define NO_WINDOW 0xFF
+#endif
+
 static struct
 {
+#ifdef LCD_TILES
+    /* background image in program memory, NULL if blank */
+    const uint8_t *background;
+
+    /* characters on the grid of 6x8 cells, 0 for none */
+    char tiles[6][14];
+
+    /* display list, drawn over the tiles in order */
+    struct overlay overlays[NOKIA_LCD_OVERLAYS];
+    uint8_t overlay_count;
+
+    /* characters of the text overlays, packed */
+    char text[NOKIA_LCD_TEXT];
+    uint8_t text_used;
+
+    /* drawings that found the list or the text space full */
+    uint8_t dropped;
+
+    /* bank being composed by render, NO_WINDOW while drawing */
+    uint8_t *window;
+    uint8_t window_bank;
+#else
     /* screen byte massive */
     uint8_t screen[504];
+#endif
 
     /* cursor position */
     uint8_t cursor_x;
     uint8_t cursor_y;
 
+    /* columns changed since the last render, per bank (x0 > x1: clean) */
+    uint8_t dirty_x0[6];
+    uint8_t dirty_x1[6];
+
+    /* bytes (commands and data) of the last frame rendered */
+    uint16_t frame_bytes;
+
 } nokia_lcd = {
+#ifdef LCD_TILES
+    .window_bank = NO_WINDOW,
+#endif
     .cursor_x = 0,
-    .cursor_y = 0};
+    .cursor_y = 0,
+    .dirty_x0 = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
+
+/*
+ * Screen access of the drawing code. Without a screen buffer the drawing
+ * calls are recorded (RECORD returns from the caller), and only do their
+ * drawing when render replays them into one bank: the window
+ */
+#ifdef LCD_TILES
+#define RECORDING (nokia_lcd.window_bank == NO_WINDOW)
+#define RECORD(kind, x1, y1, x2, y2, value, data)                  \
+    do                                                             \
+    {                                                              \
+        if (RECORDING)                                             \
+        {                                                          \
+            record(kind, x1, y1, x2, y2, value, data);             \
+            return;                                                \
+        }                                                          \
+    } while (0)
+#define IN_WINDOW(bank) ((bank) == nokia_lcd.window_bank)
+#define SCREEN(bank, x) (&nokia_lcd.window[x])
+#else
+#define RECORD(kind, x1, y1, x2, y2, value, data) do { } while (0)
+#define IN_WINDOW(bank) 1
+#define SCREEN(bank, x) (&nokia_lcd.screen[(bank) * 84 + (x)])
+#endif
+
+#ifdef LCD_ASYNC
+static struct
+{
+    /* copy of the screen being streamed by the SPI interrupt */
+    uint8_t front[504];
+
+    /* spans of the front buffer to send, as taken from nokia_lcd.dirty_* */
+    uint8_t x0[6];
+    uint8_t x1[6];
+
+    /* span being sent, what goes out next and how many data bytes are left */
+    uint8_t bank;
+    uint8_t phase;
+    const uint8_t *next;
+    uint8_t left;
+
+    volatile uint8_t busy;
+
+} nokia_async;
+
+enum
+{
+    ASYNC_X,
+    ASYNC_Y,
+    ASYNC_DATA,
+    ASYNC_DONE
+};
+#endif
 
 /**
- * Sending data to LCD
- * @bytes: data
- * @is_data: transfer mode: 1 - data; 0 - command;
+ * Grow the dirty span of a bank
+ * @bank: bank (0-5)
+ * @x0: first changed column
+ * @x1: last changed column
  */
-static void write(uint8_t bytes, uint8_t is_data)
+static inline void mark_dirty(uint8_t bank, uint8_t x0, uint8_t x1)
+{
+#ifdef LCD_TILES
+    if (!RECORDING)
+        return; // replaying: the spans were marked when the calls were recorded
+#endif
+    if (x0 < nokia_lcd.dirty_x0[bank])
+        nokia_lcd.dirty_x0[bank] = x0;
+    if (x1 > nokia_lcd.dirty_x1[bank])
+        nokia_lcd.dirty_x1[bank] = x1;
+}
+
+static inline void mark_clean(uint8_t bank)
+{
+    nokia_lcd.dirty_x0[bank] = 0xFF;
+    nokia_lcd.dirty_x1[bank] = 0;
+}
+
+/**
+ * Move the cursor past a character of the 5x7 font
+ * @scale: size of char
+ */
+static void advance(uint8_t scale)
+{
+    nokia_lcd.cursor_x += 5 * scale + 1;
+    if (nokia_lcd.cursor_x >= 84)
+    {
+        nokia_lcd.cursor_x = 0;
+        nokia_lcd.cursor_y += 7 * scale + 1;
+    }
+    if (nokia_lcd.cursor_y >= 48)
+    {
+        nokia_lcd.cursor_x = 0;
+        nokia_lcd.cursor_y = 0;
+    }
+}
+
+static uint8_t font_glyph(char code, const struct nokia_lcd_font *font);
+
+/**
+ * Columns a character of a proportional font takes at the cursor: the
+ * glyph and its spacing, clipped at the right edge (0 past it)
+ * @code: char code
+ * @font: font
+ */
+static uint8_t font_advance(char code, const struct nokia_lcd_font *font)
+{
+    uint8_t end = pgm_read_byte(&font->widths[font_glyph(code, font)]) + font->spacing;
+
+    if (nokia_lcd.cursor_x >= 84)
+        return 0;
+    if (nokia_lcd.cursor_x + end > 84)
+        end = 84 - nokia_lcd.cursor_x;
+    return end;
+}
+
+#ifdef LCD_TILES
+/**
+ * Mark a box as changed, clipped to the screen
+ * @x0, @y0: top left corner
+ * @x1, @y1: bottom right corner
+ */
+static void mark_box(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    register uint8_t bank;
+
+    if (x0 < 0)
+        x0 = 0;
+    if (y0 < 0)
+        y0 = 0;
+    if (x1 > 83)
+        x1 = 83;
+    if (y1 > 47)
+        y1 = 47;
+    if (x0 > x1 || y0 > y1)
+        return;
+    for (bank = y0 / 8; bank <= y1 / 8; bank++)
+        mark_dirty(bank, x0, x1);
+}
+
+/**
+ * Mark the box of each character of a text overlay, following the cursor
+ * the way the characters are drawn
+ * @o: text overlay
+ */
+static void mark_text(const struct overlay *o)
 {
     register uint8_t i;
-    /* Enable controller */
-    PORT_LCD &= ~(1 << LCD_SCE);
+    const struct nokia_lcd_font *font = o->data;
+    uint8_t cursor_x = nokia_lcd.cursor_x, cursor_y = nokia_lcd.cursor_y;
+
+    nokia_lcd.cursor_x = o->x1;
+    nokia_lcd.cursor_y = o->y1;
+    for (i = 0; i < o->y2; i++)
+    {
+        char code = nokia_lcd.text[o->x2 + i];
+        if (font)
+        {
+            uint8_t end = font_advance(code, font);
+            mark_box(nokia_lcd.cursor_x, nokia_lcd.cursor_y, nokia_lcd.cursor_x + end - 1,
+                     nokia_lcd.cursor_y + font->height - 1);
+            nokia_lcd.cursor_x += end;
+        }
+        else
+        {
+            mark_box(nokia_lcd.cursor_x, nokia_lcd.cursor_y, nokia_lcd.cursor_x + 5 * o->value - 1,
+                     nokia_lcd.cursor_y + 7 * o->value - 1);
+            advance(o->value);
+        }
+    }
+    nokia_lcd.cursor_x = cursor_x;
+    nokia_lcd.cursor_y = cursor_y;
+}
+
+/**
+ * Mark the box an overlay draws in as changed
+ * @o: overlay
+ */
+static void mark_overlay(const struct overlay *o)
+{
+    switch (o->kind)
+    {
+    case OVERLAY_PIXEL:
+    case OVERLAY_FILL:
+        mark_box(o->x1, o->y1, o->x2, o->y2);
+        break;
+    case OVERLAY_LINE:
+        mark_box(o->x1 < o->x2 ? o->x1 : o->x2, o->y1 < o->y2 ? o->y1 : o->y2,
+                 o->x1 > o->x2 ? o->x1 : o->x2, o->y1 > o->y2 ? o->y1 : o->y2);
+        break;
+    case OVERLAY_CIRCLE:
+        mark_box(o->x1 - o->x2, o->y1 - o->x2, o->x1 + o->x2, o->y1 + o->x2);
+        break;
+    case OVERLAY_SPRITE:
+        mark_box(o->x1, o->y1, o->x1 + ((const struct nokia_lcd_sprite *)o->data)->width - 1, o->y1 + 7);
+        break;
+    case OVERLAY_TEXT:
+        mark_text(o);
+        break;
+    }
+}
+
+/**
+ * Count a drawing that did not fit in the display list
+ */
+static void drop(void)
+{
+    if (nokia_lcd.dropped < 0xFF)
+        nokia_lcd.dropped++;
+}
+
+/**
+ * Mark everything on the screen as changed and empty the display list
+ * (the background stays)
+ */
+static void forget_all(void)
+{
+    register uint8_t bank, col;
+
+    for (col = 0; col < nokia_lcd.overlay_count; col++)
+        mark_overlay(&nokia_lcd.overlays[col]);
+    for (bank = 0; bank < 6; bank++)
+        for (col = 0; col < 14; col++)
+            if (nokia_lcd.tiles[bank][col])
+            {
+                mark_dirty(bank, col * 6, col * 6 + 4);
+                nokia_lcd.tiles[bank][col] = 0;
+            }
+    nokia_lcd.overlay_count = 0;
+    nokia_lcd.text_used = 0;
+    nokia_lcd.cursor_x = 0;
+    nokia_lcd.cursor_y = 0;
+}
+
+/**
+ * Add a drawing call to the display list. A call that only redraws what is
+ * already there is dropped, and one that draws the same thing at the same
+ * place with another value, frame or text (a pixel, a fill, a sprite or a
+ * text) updates it. The list is full: the call is dropped, and counted.
+ */
+static void record(uint8_t kind, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t value, const void *data)
+{
+    register uint8_t i;
+    struct overlay *o = nokia_lcd.overlays;
+
+    for (i = 0; i < nokia_lcd.overlay_count; i++, o++)
+    {
+        if (o->kind != kind || o->x1 != x1 || o->y1 != y1)
+            continue;
+        if (kind == OVERLAY_SPRITE || ((kind == OVERLAY_PIXEL || kind == OVERLAY_FILL) && o->x2 == x2 && o->y2 == y2))
+        {
+            if (o->value == value && o->data == data)
+                return;
+            mark_overlay(o);
+            break;
+        }
+        if (o->x2 == x2 && o->y2 == y2 && o->value == value)
+            return;
+    }
+    if (i == nokia_lcd.overlay_count)
+    {
+        if (i == NOKIA_LCD_OVERLAYS)
+        {
+            drop();
+            return;
+        }
+        nokia_lcd.overlay_count++;
+    }
+    o->kind = kind;
+    o->x1 = x1;
+    o->y1 = y1;
+    o->x2 = x2;
+    o->y2 = y2;
+    o->value = value;
+    o->data = data;
+    mark_overlay(o);
+}
+
+/**
+ * Add a text to the display list at the cursor, or update the one already
+ * there. The characters are kept packed: a text that changes its length
+ * moves to the end. The cursor is not moved.
+ * @str: characters
+ * @length: how many
+ * @scale: size of the 5x7 font, 0 with a proportional font
+ * @font: proportional font, NULL for the 5x7 font
+ */
+static void record_text(const char *str, uint8_t length, uint8_t scale, const struct nokia_lcd_font *font)
+{
+    register uint8_t i;
+    struct overlay *o = nokia_lcd.overlays;
+
+    for (i = 0; i < nokia_lcd.overlay_count; i++, o++)
+        if (o->kind == OVERLAY_TEXT && o->x1 == nokia_lcd.cursor_x && o->y1 == nokia_lcd.cursor_y)
+            break;
+    if (i < nokia_lcd.overlay_count)
+    {
+        if (o->y2 == length && o->value == scale && o->data == font)
+        {
+            if (!memcmp(&nokia_lcd.text[o->x2], str, length))
+                return;
+            mark_overlay(o);
+            memcpy(&nokia_lcd.text[o->x2], str, length);
+            mark_overlay(o);
+            return;
+        }
+
+        /* Take the old characters out, closing the gap */
+        struct overlay *other = nokia_lcd.overlays;
+        mark_overlay(o);
+        memmove(&nokia_lcd.text[o->x2], &nokia_lcd.text[o->x2 + o->y2], nokia_lcd.text_used - o->x2 - o->y2);
+        nokia_lcd.text_used -= o->y2;
+        for (i = 0; i < nokia_lcd.overlay_count; i++, other++)
+            if (other->kind == OVERLAY_TEXT && other->x2 > o->x2)
+                other->x2 -= o->y2;
+    }
+    else if (nokia_lcd.overlay_count < NOKIA_LCD_OVERLAYS)
+        nokia_lcd.overlay_count++;
+    else
+    {
+        drop();
+        return;
+    }
+    if (length > NOKIA_LCD_TEXT - nokia_lcd.text_used)
+    {
+        /* No room left: the overlay is taken out (the last one moves into its slot) */
+        *o = nokia_lcd.overlays[--nokia_lcd.overlay_count];
+        drop();
+        return;
+    }
+    o->kind = OVERLAY_TEXT;
+    o->x1 = nokia_lcd.cursor_x;
+    o->y1 = nokia_lcd.cursor_y;
+    o->x2 = nokia_lcd.text_used;
+    o->y2 = length;
+    o->value = scale;
+    o->data = font;
+    memcpy(&nokia_lcd.text[o->x2], str, length);
+    nokia_lcd.text_used += length;
+    mark_overlay(o);
+}
+#endif
 
-    /* We are sending data */
+/*
+ * Transport
+ *
+ * A transfer is framed by lcd_begin()/lcd_end(): SCE stays low for the whole
+ * burst and DC is only touched when the mode actually changes, so a full
+ * frame costs one select and one DC toggle instead of one per byte.
+ */
+
+/**
+ * Select transfer mode, only valid between bytes
+ * @is_data: transfer mode: 1 - data; 0 - command;
+ */
+static inline void lcd_mode(uint8_t is_data)
+{
     if (is_data)
         PORT_LCD |= (1 << LCD_DC);
-    /* We are sending commands */
     else
         PORT_LCD &= ~(1 << LCD_DC);
+}
+
+/**
+ * Enable controller and select transfer mode
+ * @is_data: transfer mode: 1 - data; 0 - command;
+ */
+static inline void lcd_begin(uint8_t is_data)
+{
+    PORT_LCD &= ~(1 << LCD_SCE);
+    lcd_mode(is_data);
+}
+
+/*
+ * Disable controller
+ */
+static inline void lcd_end(void)
+{
+    PORT_LCD |= (1 << LCD_SCE);
+}
+
+#ifdef LCD_SPI
+/*
+ * SPI at fosc/2: the byte is shifted out 16 cycles after SPDR is loaded
+ */
+static inline void lcd_send(uint8_t byte)
+{
+    SPDR = byte;
+    while (!(SPSR & (1 << SPIF)))
+        ;
+}
+#else
+static inline void lcd_send(uint8_t byte)
+{
+    register uint8_t i;
 
     /* Send bytes */
     for (i = 0; i < 8; i++)
     {
         /* Set data pin to byte state */
-        if ((bytes >> (7 - i)) & 0x01)
+        if (byte & 0x80)
             PORT_LCD |= (1 << LCD_DIN);
         else
             PORT_LCD &= ~(1 << LCD_DIN);
@@ -62,20 +506,27 @@ static void write(uint8_t bytes, uint8_t is_data)
         /* Blink clock */
         PORT_LCD |= (1 << LCD_CLK);
         PORT_LCD &= ~(1 << LCD_CLK);
+        byte <<= 1;
     }
-
-    /* Disable controller */
-    PORT_LCD |= (1 << LCD_SCE);
 }
+#endif
 
-static void write_cmd(uint8_t cmd)
+/**
+ * Sending data to LCD
+ * @bytes: data
+ * @is_data: transfer mode: 1 - data; 0 - command;
+ */
+static void write(uint8_t bytes, uint8_t is_data)
 {
-    write(cmd, 0);
+    nokia_lcd_flush();
+    lcd_begin(is_data);
+    lcd_send(bytes);
+    lcd_end();
 }
 
-static void write_data(uint8_t data)
+static void write_cmd(uint8_t cmd)
 {
-    write(data, 1);
+    write(cmd, 0);
 }
 
 /*
@@ -92,6 +543,12 @@ void nokia_lcd_init(void)
     DDR_LCD |= (1 << LCD_DIN);
     DDR_LCD |= (1 << LCD_CLK);
 
+#ifdef LCD_SPI
+    /* SPI master, mode 0, MSB first, fosc/2 */
+    SPCR = (1 << SPE) | (1 << MSTR);
+    SPSR = (1 << SPI2X);
+#endif
+
     /* Reset display */
     PORT_LCD |= (1 << LCD_RST);
     PORT_LCD |= (1 << LCD_SCE);
@@ -121,24 +578,85 @@ void nokia_lcd_init(void)
     /* Clear LCD RAM */
     write_cmd(0x80);
     write_cmd(LCD_CONTRAST);
+    lcd_begin(1);
     for (i = 0; i < 504; i++)
-        write_data(0x00);
+        lcd_send(0x00);
+    lcd_end();
 
     /* Activate LCD */
     write_cmd(0x08);
     write_cmd(0x0C);
 }
 
+#ifdef LCD_TILES
 void nokia_lcd_clear(void)
 {
-    /* Set column and row to 0 */
-    write_cmd(0x80);
-    write_cmd(0x40);
-    /*Cursor too */
+    nokia_lcd_load_P(NULL);
+}
+
+void nokia_lcd_load_P(const uint8_t *image)
+{
+    register uint8_t bank, x;
+    const uint8_t *old = nokia_lcd.background;
+
+    forget_all();
+    /* Only the columns where the backgrounds differ are sent */
+    for (bank = 0; bank < 6; bank++)
+        for (x = 0; x < 84; x++)
+        {
+            uint16_t i = bank * 84 + x;
+            if ((old ? pgm_read_byte(&old[i]) : 0) != (image ? pgm_read_byte(&image[i]) : 0))
+                mark_dirty(bank, x, x);
+        }
+    nokia_lcd.background = image;
+}
+#else
+void nokia_lcd_clear(void)
+{
+    register uint8_t bank, x;
+    uint8_t *row = nokia_lcd.screen;
+
+    /* Cursor to 0 (render sets the display address itself) */
+    nokia_lcd.cursor_x = 0;
+    nokia_lcd.cursor_y = 0;
+    /* Clear everything (504 bytes = 84cols * 48 rows / 8 bits), keeping
+       track of the columns that were actually lit */
+    for (bank = 0; bank < 6; bank++, row += 84)
+        for (x = 0; x < 84; x++)
+            if (row[x])
+            {
+                mark_dirty(bank, x, x);
+                row[x] = 0;
+            }
+}
+
+void nokia_lcd_load_P(const uint8_t *image)
+{
+    register uint8_t bank, x;
+    uint8_t *row = nokia_lcd.screen;
+
     nokia_lcd.cursor_x = 0;
     nokia_lcd.cursor_y = 0;
-    /* Clear everything (504 bytes = 84cols * 48 rows / 8 bits) */
-    memset(nokia_lcd.screen, 0, 504);
+    /* Copy compared byte by byte, like clear: switching between screens
+       that share most of their background only sends the difference */
+    for (bank = 0; bank < 6; bank++, row += 84, image += 84)
+        for (x = 0; x < 84; x++)
+        {
+            uint8_t b = pgm_read_byte(&image[x]);
+            if (row[x] != b)
+            {
+                mark_dirty(bank, x, x);
+                row[x] = b;
+            }
+        }
+}
+#endif
+
+void nokia_lcd_invalidate(void)
+{
+    register uint8_t bank;
+    for (bank = 0; bank < 6; bank++)
+        mark_dirty(bank, 0, 83);
 }
 
 void nokia_lcd_power(uint8_t on)
@@ -148,11 +666,118 @@ void nokia_lcd_power(uint8_t on)
 
 void nokia_lcd_set_pixel(uint8_t x, uint8_t y, uint8_t value)
 {
-    uint8_t *byte = &nokia_lcd.screen[y / 8 * 84 + x];
+    uint8_t bank = y / 8;
+
+    if (x > 83 || y > 47)
+        return;
+    RECORD(OVERLAY_PIXEL, x, y, x, y, value, NULL);
+    if (!IN_WINDOW(bank))
+        return;
+    uint8_t *byte = SCREEN(bank, x);
+    uint8_t old = *byte;
     if (value)
         *byte |= (1 << (y % 8));
     else
         *byte &= ~(1 << (y % 8));
+    if (*byte != old)
+        mark_dirty(bank, x, x);
+}
+
+/*
+ * Glyph columns are 7 bits high; scaling a column repeats each bit, which
+ * is done a nibble at a time with these tables (nibble -> 8 or 12 bits)
+ */
+static const uint8_t EXPAND2[16] PROGMEM = {
+    0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+    0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF};
+
+static const uint16_t EXPAND3[16] PROGMEM = {
+    0x000, 0x007, 0x038, 0x03F, 0x1C0, 0x1C7, 0x1F8, 0x1FF,
+    0xE00, 0xE07, 0xE38, 0xE3F, 0xFC0, 0xFC7, 0xFF8, 0xFFF};
+
+/**
+ * Write one column of bits at (x, y), touching only the rows in mask.
+ * Bank aligned columns land in a single byte, others are shifted and
+ * merged into the banks they straddle.
+ * @x: column
+ * @y: row of bit 0
+ * @bits: column pixels, bit 0 on top
+ * @mask: rows to write
+ */
+static void blit_column(uint8_t x, uint8_t y, uint32_t bits, uint32_t mask)
+{
+    uint8_t bank = y / 8;
+
+    if (x > 83)
+        return;
+    bits <<= y % 8;
+    mask <<= y % 8;
+    for (; mask && bank < 6; bank++, bits >>= 8, mask >>= 8)
+    {
+        if (!IN_WINDOW(bank))
+            continue;
+        uint8_t *byte = SCREEN(bank, x);
+        uint8_t m = mask;
+        uint8_t b = (*byte & ~m) | (bits & m);
+        if (b != *byte)
+        {
+            *byte = b;
+            mark_dirty(bank, x, x);
+        }
+    }
+}
+
+void nokia_lcd_draw_sprite(uint8_t x, uint8_t y, const struct nokia_lcd_sprite *sprite, uint8_t frame)
+{
+    register uint8_t c;
+    uint8_t width = sprite->width;
+    const uint8_t *bits = sprite->frames + frame * 2 * width;
+    const uint8_t *mask = bits + width;
+    uint8_t bank = y / 8, shift = y % 8;
+    uint8_t *top = SCREEN(bank, x);
+    uint8_t *bottom = SCREEN(bank + 1, x);
+    uint8_t first[2] = {0xFF, 0xFF}, last[2] = {0, 0};
+
+    if (x > 83 || y > 47)
+        return;
+    RECORD(OVERLAY_SPRITE, x, y, 0, 0, frame, sprite);
+    if (width > 84 - x)
+        width = 84 - x;
+
+    /* 16 bit columns: the low byte lands in the top bank, the high one in
+       the bank below (only when the sprite is not bank aligned) */
+    for (c = 0; c < width; c++)
+    {
+        uint16_t b = pgm_read_byte(&bits[c]) << shift;
+        uint16_t m = pgm_read_byte(&mask[c]) << shift;
+        uint8_t t;
+        if (IN_WINDOW(bank))
+        {
+            t = (top[c] & ~m) | (b & m);
+            if (t != top[c])
+            {
+                top[c] = t;
+                if (first[0] == 0xFF)
+                    first[0] = c;
+                last[0] = c;
+            }
+        }
+        if (m >> 8 && bank < 5 && IN_WINDOW(bank + 1))
+        {
+            t = (bottom[c] & ~(m >> 8)) | (b >> 8 & m >> 8);
+            if (t != bottom[c])
+            {
+                bottom[c] = t;
+                if (first[1] == 0xFF)
+                    first[1] = c;
+                last[1] = c;
+            }
+        }
+    }
+    if (first[0] != 0xFF)
+        mark_dirty(bank, x + first[0], x + last[0]);
+    if (first[1] != 0xFF)
+        mark_dirty(bank + 1, x + first[1], x + last[1]);
 }
 
 void nokia_lcd_write_char(char code, uint8_t scale)
@@ -161,6 +786,25 @@ void nokia_lcd_write_char(char code, uint8_t scale)
 
     if (code >= 0x80)
         return; // 7 bit ASCII only
+#ifdef LCD_TILES
+    if (RECORDING)
+    {
+        /* Characters on the cell grid are tiles, the others are texts */
+        if (scale == 1 && code && nokia_lcd.cursor_x % 6 == 0 && nokia_lcd.cursor_y % 8 == 0)
+        {
+            char *tile = &nokia_lcd.tiles[nokia_lcd.cursor_y / 8][nokia_lcd.cursor_x / 6];
+            if (*tile != code)
+            {
+                *tile = code;
+                mark_dirty(nokia_lcd.cursor_y / 8, nokia_lcd.cursor_x, nokia_lcd.cursor_x + 4);
+            }
+        }
+        else
+            record_text(&code, 1, scale, NULL);
+        advance(scale);
+        return;
+    }
+#endif
     const uint8_t *glyph;
     uint8_t pgm_buffer[5];
     if (code >= ' ')
@@ -182,25 +826,48 @@ void nokia_lcd_write_char(char code, uint8_t scale)
             glyph = pgm_buffer;
         }
     }
-    for (x = 0; x < 5 * scale; x++)
-        for (y = 0; y < 7 * scale; y++)
-            //if (pgm_read_byte(&CHARSET[code-32][x/scale]) & (1 << y/scale))
-            if (glyph[x / scale] & (1 << y / scale))
-                nokia_lcd_set_pixel(nokia_lcd.cursor_x + x, nokia_lcd.cursor_y + y, 1);
-            else
-                nokia_lcd_set_pixel(nokia_lcd.cursor_x + x, nokia_lcd.cursor_y + y, 0);
-
-    nokia_lcd.cursor_x += 5 * scale + 1;
-    if (nokia_lcd.cursor_x >= 84)
+    if (scale == 1 && nokia_lcd.cursor_y % 8 == 0)
     {
-        nokia_lcd.cursor_x = 0;
-        nokia_lcd.cursor_y += 7 * scale + 1;
+        /* Bank aligned: one byte per column, bit 7 (the gap row) is kept */
+        uint8_t *byte = SCREEN(nokia_lcd.cursor_y / 8, nokia_lcd.cursor_x);
+        for (x = 0; x < 5 && nokia_lcd.cursor_x + x < 84 && IN_WINDOW(nokia_lcd.cursor_y / 8); x++)
+        {
+            uint8_t b = (byte[x] & 0x80) | (glyph[x] & 0x7F);
+            if (b != byte[x])
+            {
+                byte[x] = b;
+                mark_dirty(nokia_lcd.cursor_y / 8, nokia_lcd.cursor_x + x, nokia_lcd.cursor_x + x);
+            }
+        }
     }
-    if (nokia_lcd.cursor_y >= 48)
+    else if (scale <= 3)
     {
-        nokia_lcd.cursor_x = 0;
-        nokia_lcd.cursor_y = 0;
+        for (x = 0; x < 5; x++)
+        {
+            uint8_t column = glyph[x] & 0x7F;
+            uint32_t bits;
+            if (scale == 1)
+                bits = column;
+            else if (scale == 2)
+                bits = pgm_read_byte(&EXPAND2[column & 0x0F]) |
+                       (uint16_t)pgm_read_byte(&EXPAND2[column >> 4]) << 8;
+            else
+                bits = pgm_read_word(&EXPAND3[column & 0x0F]) |
+                       (uint32_t)pgm_read_word(&EXPAND3[column >> 4]) << 12;
+            for (y = 0; y < scale; y++)
+                blit_column(nokia_lcd.cursor_x + x * scale + y, nokia_lcd.cursor_y, bits,
+                            (1UL << 7 * scale) - 1);
+        }
+    }
+    else
+    {
+        /* Larger sizes are rare enough to go pixel by pixel */
+        for (x = 0; x < 5 * scale; x++)
+            for (y = 0; y < 7 * scale; y++)
+                nokia_lcd_set_pixel(nokia_lcd.cursor_x + x, nokia_lcd.cursor_y + y,
+                                    glyph[x / scale] & (1 << y / scale));
     }
+    advance(scale);
 }
 
 void nokia_lcd_custom(char code, uint8_t *glyph)
@@ -213,62 +880,605 @@ void nokia_lcd_custom(char code, uint8_t *glyph)
 
 void nokia_lcd_write_string(const char *str, uint8_t scale)
 {
+#ifdef LCD_TILES
+    /* Off the cell grid the whole string is a single text */
+    if (RECORDING && (scale != 1 || nokia_lcd.cursor_x % 6 || nokia_lcd.cursor_y % 8))
+    {
+        record_text(str, strlen(str), scale, NULL);
+        while (*str++)
+            advance(scale);
+        return;
+    }
+#endif
     while (*str)
         nokia_lcd_write_char(*str++, scale);
 }
 
+static uint8_t font_glyph(char code, const struct nokia_lcd_font *font)
+{
+    if (code < font->first || code > font->last)
+        return 0;
+    return code - font->first;
+}
+
+void nokia_lcd_write_char_font(char code, const struct nokia_lcd_font *font)
+{
+    register uint8_t x, i;
+    uint8_t glyph = font_glyph(code, font);
+    uint8_t width = pgm_read_byte(&font->widths[glyph]);
+    uint8_t end = font_advance(code, font); // clipped, the rest of the string is skipped too
+    uint8_t bytes = (font->height + 7) / 8;
+    uint32_t mask = (1UL << font->height) - 1;
+    const uint8_t *column = &font->bitmap[pgm_read_word(&font->offsets[glyph])];
+
+    if (!end) // the cursor is past the right edge
+        return;
+#ifdef LCD_TILES
+    if (RECORDING)
+    {
+        record_text(&code, 1, 0, font);
+        nokia_lcd.cursor_x += end;
+        return;
+    }
+#endif
+    if (nokia_lcd.cursor_y % 8 == 0)
+    {
+        /* Bank aligned: the column bytes go straight into the banks */
+        uint8_t bank = nokia_lcd.cursor_y / 8;
+        for (i = 0; i < bytes && bank < 6; i++, bank++, mask >>= 8)
+        {
+            if (!IN_WINDOW(bank))
+                continue;
+            uint8_t m = mask;
+            uint8_t *byte = SCREEN(bank, nokia_lcd.cursor_x);
+            uint8_t first = 0xFF, last = 0;
+            for (x = 0; x < end; x++)
+            {
+                uint8_t b = (byte[x] & ~m) | (x < width ? pgm_read_byte(&column[x * bytes + i]) & m : 0);
+                if (b != byte[x])
+                {
+                    byte[x] = b;
+                    if (first == 0xFF)
+                        first = x;
+                    last = x;
+                }
+            }
+            if (first != 0xFF)
+                mark_dirty(bank, nokia_lcd.cursor_x + first, nokia_lcd.cursor_x + last);
+        }
+    }
+    else
+    {
+        for (x = 0; x < end; x++)
+        {
+            uint32_t bits = 0;
+            if (x < width)
+                for (i = 0; i < bytes; i++)
+                    bits |= (uint32_t)pgm_read_byte(column++) << 8 * i;
+            blit_column(nokia_lcd.cursor_x + x, nokia_lcd.cursor_y, bits, mask);
+        }
+    }
+    nokia_lcd.cursor_x += end;
+}
+
+void nokia_lcd_write_string_font(const char *str, const struct nokia_lcd_font *font)
+{
+#ifdef LCD_TILES
+    if (RECORDING)
+    {
+        record_text(str, strlen(str), 0, font);
+        while (*str && nokia_lcd.cursor_x < 84)
+            nokia_lcd.cursor_x += font_advance(*str++, font);
+        return;
+    }
+#endif
+    while (*str && nokia_lcd.cursor_x < 84)
+        nokia_lcd_write_char_font(*str++, font);
+}
+
+uint8_t nokia_lcd_string_width(const char *str, const struct nokia_lcd_font *font)
+{
+    uint16_t width = 0;
+
+    while (*str)
+        width += pgm_read_byte(&font->widths[font_glyph(*str++, font)]) + font->spacing;
+    if (width)
+        width -= font->spacing;
+    return width > 255 ? 255 : width;
+}
+
+void nokia_lcd_write_string_centered(const char *str, uint8_t y, const struct nokia_lcd_font *font)
+{
+    uint8_t width = nokia_lcd_string_width(str, font);
+
+    nokia_lcd_set_cursor(width < 84 ? (84 - width) / 2 : 0, y);
+    nokia_lcd_write_string_font(str, font);
+}
+
 void nokia_lcd_set_cursor(uint8_t x, uint8_t y)
 {
     nokia_lcd.cursor_x = x;
     nokia_lcd.cursor_y = y;
 }
 
+#ifdef LCD_TILES
+static void fill(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, uint8_t value);
+
+/**
+ * Draw one bank: the background, the tiles and the overlays, replayed in
+ * the order they were recorded with the drawing limited to the bank
+ * @bank: bank (0-5)
+ * @window: 84 bytes where the bank is drawn
+ */
+static void compose(uint8_t bank, uint8_t *window)
+{
+    register uint8_t i;
+    uint8_t cursor_x = nokia_lcd.cursor_x, cursor_y = nokia_lcd.cursor_y;
+
+    if (nokia_lcd.background)
+        memcpy_P(window, &nokia_lcd.background[bank * 84], 84);
+    else
+        memset(window, 0, 84);
+    nokia_lcd.window = window;
+    nokia_lcd.window_bank = bank;
+
+    for (i = 0; i < 14; i++)
+        if (nokia_lcd.tiles[bank][i])
+        {
+            nokia_lcd_set_cursor(i * 6, bank * 8);
+            nokia_lcd_write_char(nokia_lcd.tiles[bank][i], 1);
+        }
+    for (i = 0; i < nokia_lcd.overlay_count; i++)
+    {
+        const struct overlay *o = &nokia_lcd.overlays[i];
+        uint8_t c;
+        switch (o->kind)
+        {
+        case OVERLAY_PIXEL:
+            nokia_lcd_set_pixel(o->x1, o->y1, o->value);
+            break;
+        case OVERLAY_FILL:
+            fill(o->x1, o->x2, o->y1, o->y2, o->value);
+            break;
+        case OVERLAY_LINE:
+            nokia_lcd_drawline(o->x1, o->y1, o->x2, o->y2);
+            break;
+        case OVERLAY_CIRCLE:
+            nokia_lcd_drawcircle(o->x1, o->y1, o->x2);
+            break;
+        case OVERLAY_SPRITE:
+            nokia_lcd_draw_sprite(o->x1, o->y1, o->data, o->value);
+            break;
+        case OVERLAY_TEXT:
+            nokia_lcd_set_cursor(o->x1, o->y1);
+            for (c = 0; c < o->y2; c++)
+                if (o->data)
+                    nokia_lcd_write_char_font(nokia_lcd.text[o->x2 + c], o->data);
+                else
+                    nokia_lcd_write_char(nokia_lcd.text[o->x2 + c], o->value);
+            break;
+        }
+    }
+
+    nokia_lcd.window_bank = NO_WINDOW;
+    nokia_lcd.cursor_x = cursor_x;
+    nokia_lcd.cursor_y = cursor_y;
+}
+#endif
+
+/**
+ * Clip a window to the changed columns of a bank, and take them out of its
+ * dirty span (a window in the middle of the span leaves it whole: those
+ * columns will be sent again, which is harmless)
+ * @bank: bank (0-5)
+ * @x0: first column of the window, moved to the first one to send
+ * @x1: last column of the window, moved to the last one to send
+ * Return: 1 - there are columns to send; 0 - none changed in the window;
+ */
+static uint8_t take_span(uint8_t bank, uint8_t *x0, uint8_t *x1)
+{
+    uint8_t d0 = nokia_lcd.dirty_x0[bank];
+    uint8_t d1 = nokia_lcd.dirty_x1[bank];
+
+    if (*x0 < d0)
+        *x0 = d0;
+    if (*x1 > d1)
+        *x1 = d1;
+    if (*x0 > *x1)
+        return 0;
+
+    if (*x0 == d0 && *x1 == d1)
+        mark_clean(bank);
+    else if (*x0 == d0)
+        nokia_lcd.dirty_x0[bank] = *x1 + 1;
+    else if (*x1 == d1)
+        nokia_lcd.dirty_x1[bank] = *x0 - 1;
+    return 1;
+}
+
+/**
+ * Send the changed columns of a bank that lie in a window (see take_span)
+ * @bank: bank (0-5)
+ * @x0: first column of the window
+ * @x1: last column of the window
+ * Return: bytes sent, commands included;
+ */
+static uint16_t send_span(uint8_t bank, uint8_t x0, uint8_t x1)
+{
+    register uint8_t x;
+#ifdef LCD_TILES
+    uint8_t window[84];
+#endif
+
+    if (!take_span(bank, &x0, &x1))
+        return 0;
+
+    /* Set column and row to the start of the span */
+    lcd_mode(0);
+    lcd_send(0x80 | x0);
+    lcd_send(0x40 | bank);
+
+    /* Write the span in a single burst */
+#ifdef LCD_TILES
+    const uint8_t *row = window;
+    compose(bank, window);
+#else
+    const uint8_t *row = &nokia_lcd.screen[bank * 84];
+#endif
+    lcd_mode(1);
+    for (x = x0; x <= x1; x++)
+        lcd_send(row[x]);
+    return 2 + x1 - x0 + 1;
+}
+
+#ifdef LCD_ASYNC
+static void async_start(uint8_t bank0, uint8_t bank1, uint8_t x0, uint8_t x1);
+#endif
+
 void nokia_lcd_render(void)
 {
-    register unsigned i;
-    /* Set column and row to 0 */
-    write_cmd(0x80);
-    write_cmd(0x40);
+    register uint8_t bank;
+    uint16_t bytes = 0;
+    nokia_lcd_flush();
 
-    /* Write screen to display */
-    for (i = 0; i < 504; i++)
-        write_data(nokia_lcd.screen[i]);
+    lcd_begin(0);
+    for (bank = 0; bank < 6; bank++)
+        bytes += send_span(bank, 0, 83);
+    lcd_end();
+    nokia_lcd.frame_bytes = bytes;
 }
 
-// Algoritmo DDA
-// https://en.wikipedia.org/wiki/Digital_differential_analyzer_(graphics_algorithm)
-// Bem ineficiente, mas funciona :-)
-void nokia_lcd_drawline(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2)
+void nokia_lcd_render_bank_span(uint8_t bank, uint8_t x0, uint8_t x1)
+{
+    if (bank > 5)
+        return;
+    if (x1 > 83)
+        x1 = 83;
+    nokia_lcd_flush();
+
+#ifdef LCD_ASYNC
+    async_start(bank, bank, x0, x1);
+#else
+    lcd_begin(0);
+    nokia_lcd.frame_bytes = send_span(bank, x0, x1);
+    lcd_end();
+#endif
+}
+
+void nokia_lcd_render_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h)
+{
+#ifndef LCD_ASYNC
+    register uint8_t bank;
+    uint16_t bytes = 0;
+#endif
+    uint8_t x1 = x + w - 1, y1 = y + h - 1;
+
+    if (!w || !h || x > 83 || y > 47)
+        return;
+    if (x1 > 83 || x1 < x)
+        x1 = 83;
+    if (y1 > 47 || y1 < y)
+        y1 = 47;
+    nokia_lcd_flush();
+
+#ifdef LCD_ASYNC
+    async_start(y / 8, y1 / 8, x, x1);
+#else
+    lcd_begin(0);
+    for (bank = y / 8; bank <= y1 / 8; bank++)
+        bytes += send_span(bank, x, x1);
+    lcd_end();
+    nokia_lcd.frame_bytes = bytes;
+#endif
+}
+
+uint16_t nokia_lcd_frame_bytes(void)
+{
+    return nokia_lcd.frame_bytes;
+}
+
+uint8_t nokia_lcd_dropped(void)
+{
+#ifdef LCD_TILES
+    return nokia_lcd.dropped;
+#else
+    return 0;
+#endif
+}
+
+#ifdef LCD_ASYNC
+/*
+ * One interrupt per byte: at fosc/2 the handler would be slower than the
+ * wire and eat the whole CPU, so background frames are clocked at fosc/16
+ * (128 cycles per byte), which leaves roughly two thirds of the CPU to the
+ * main loop while a frame (~4 ms) is in flight.
+ */
+/**
+ * Look for the next span to send, starting at a bank
+ * @bank: first bank to look at
+ */
+static void async_seek(uint8_t bank)
+{
+    while (bank < 6 && nokia_async.x0[bank] > nokia_async.x1[bank])
+        bank++;
+    nokia_async.bank = bank;
+    nokia_async.phase = bank < 6 ? ASYNC_X : ASYNC_DONE;
+}
+
+/*
+ * Each span goes out as the X and Y address commands followed by its data;
+ * DC is only switched here, after the previous byte has left the shifter
+ */
+static void async_step(void)
+{
+    uint8_t bank = nokia_async.bank;
+
+    switch (nokia_async.phase)
+    {
+    case ASYNC_X:
+        lcd_mode(0);
+        SPDR = 0x80 | nokia_async.x0[bank];
+        nokia_async.phase = ASYNC_Y;
+        break;
+    case ASYNC_Y:
+        SPDR = 0x40 | bank;
+        nokia_async.next = &nokia_async.front[bank * 84 + nokia_async.x0[bank]];
+        nokia_async.left = nokia_async.x1[bank] - nokia_async.x0[bank] + 1;
+        nokia_async.phase = ASYNC_DATA;
+        break;
+    case ASYNC_DATA:
+        lcd_mode(1);
+        SPDR = *nokia_async.next++;
+        if (--nokia_async.left == 0)
+            async_seek(bank + 1);
+        break;
+    default:
+        /* Back to polled transfers at fosc/2 */
+        SPCR = (1 << SPE) | (1 << MSTR);
+        SPSR = (1 << SPI2X);
+        lcd_end();
+        nokia_async.busy = 0;
+    }
+}
+
+ISR(SPI_STC_vect)
+{
+    async_step();
+}
+
+/**
+ * Copy the changed columns of some banks that lie in a window to the front
+ * buffer, and start sending them (the display must be idle)
+ * @bank0: first bank
+ * @bank1: last bank
+ * @x0: first column of the window
+ * @x1: last column of the window
+ */
+static void async_start(uint8_t bank0, uint8_t bank1, uint8_t x0, uint8_t x1)
+{
+    register uint8_t bank;
+    uint16_t bytes = 0;
+
+    /* Hand the dirty spans over to the front buffer */
+    for (bank = 0; bank < 6; bank++)
+    {
+        uint8_t s0 = x0, s1 = x1;
+        if (bank < bank0 || bank > bank1 || !take_span(bank, &s0, &s1))
+        {
+            nokia_async.x0[bank] = 0xFF;
+            nokia_async.x1[bank] = 0;
+            continue;
+        }
+        nokia_async.x0[bank] = s0;
+        nokia_async.x1[bank] = s1;
+        memcpy(&nokia_async.front[bank * 84 + s0], &nokia_lcd.screen[bank * 84 + s0], s1 - s0 + 1);
+        bytes += 2 + s1 - s0 + 1;
+    }
+    nokia_lcd.frame_bytes = bytes;
+    async_seek(0);
+    if (nokia_async.phase == ASYNC_DONE)
+        return;
+
+    nokia_async.busy = 1;
+    lcd_begin(0);
+
+    /* Slow clock first, then the first byte (clears SPIF), then the interrupt */
+    (void)SPSR;
+    SPSR = 0;
+    SPCR = (1 << SPE) | (1 << MSTR) | (1 << SPR0);
+    async_step();
+    SPCR |= (1 << SPIE);
+}
+
+uint8_t nokia_lcd_render_async(void)
+{
+    if (nokia_async.busy)
+        return 0;
+    async_start(0, 5, 0, 83);
+    return 1;
+}
+
+uint8_t nokia_lcd_busy(void)
+{
+    return nokia_async.busy;
+}
+
+void nokia_lcd_flush(void)
+{
+    while (nokia_async.busy)
+    {
+        /* With interrupts off (e.g. called from an ISR) finish the frame by hand */
+        if (!(SREG & (1 << SREG_I)) && (SPSR & (1 << SPIF)))
+            async_step();
+    }
+}
+#else
+uint8_t nokia_lcd_render_async(void)
+{
+    nokia_lcd_render();
+    return 1;
+}
+
+uint8_t nokia_lcd_busy(void)
+{
+    return 0;
+}
+
+void nokia_lcd_flush(void)
+{
+}
+#endif
+
+// Preenche o retângulo [x0, x1] x [y0, y1] (já ordenado), um byte por coluna
+// e por banco: as linhas de cada banco são aplicadas de uma vez com uma máscara
+static void fill(uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, uint8_t value)
+{
+    register uint8_t bank, x;
+    if (x0 > 83 || y0 > 47)
+        return;
+    if (x1 > 83)
+        x1 = 83;
+    if (y1 > 47)
+        y1 = 47;
+    RECORD(OVERLAY_FILL, x0, y0, x1, y1, value, NULL);
+
+    for (bank = y0 / 8; bank <= y1 / 8; bank++)
+    {
+        if (!IN_WINDOW(bank))
+            continue;
+        uint8_t mask = 0xFF;
+        if (bank == y0 / 8)
+            mask &= 0xFF << (y0 % 8);
+        if (bank == y1 / 8)
+            mask &= 0xFF >> (7 - y1 % 8);
+
+        uint8_t *byte = SCREEN(bank, x0);
+        uint8_t first = 0xFF, last = 0;
+        for (x = x0; x <= x1; x++, byte++)
+        {
+            uint8_t b = value ? *byte | mask : *byte & ~mask;
+            if (b != *byte)
+            {
+                *byte = b;
+                if (first == 0xFF)
+                    first = x;
+                last = x;
+            }
+        }
+        if (first != 0xFF)
+            mark_dirty(bank, first, last);
+    }
+}
+
+void nokia_lcd_hspan(uint8_t x1, uint8_t x2, uint8_t y, uint8_t value)
+{
+    if (x1 > x2)
+        fill(x2, x1, y, y, value);
+    else
+        fill(x1, x2, y, y, value);
+}
+
+void nokia_lcd_vspan(uint8_t x, uint8_t y1, uint8_t y2, uint8_t value)
 {
-    float x, y;
-    float dx, dy, step;
-    dx = (x2 - x1);
-    dy = (y2 - y1);
-    if (fabs(dx) >= fabs(dy))
-        step = fabs(dx);
+    if (y1 > y2)
+        fill(x, x, y2, y1, value);
     else
-        step = fabs(dy);
-    dx = dx / step;
-    dy = dy / step;
-    x = x1;
-    y = y1;
-    int i = 1;
-    while (i <= step)
+        fill(x, x, y1, y2, value);
+}
+
+void nokia_lcd_fillrect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t value)
+{
+    if (x1 > x2)
+    {
+        uint8_t t = x1;
+        x1 = x2;
+        x2 = t;
+    }
+    if (y1 > y2)
+    {
+        uint8_t t = y1;
+        y1 = y2;
+        y2 = t;
+    }
+    fill(x1, x2, y1, y2, value);
+}
+
+// Algoritmo de Bresenham, só com inteiros
+// https://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
+// Como o DDA que ele substitui, não desenha o ponto final (x2, y2)
+void nokia_lcd_drawline(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2)
+{
+    RECORD(OVERLAY_LINE, x1, y1, x2, y2, 1, NULL);
+
+    // Linhas horizontais e verticais viram spans
+    if (y1 == y2)
     {
-        nokia_lcd_set_pixel(x, y, 1);
-        x = x + dx;
-        y = y + dy;
-        i = i + 1;
+        if (x1 < x2)
+            fill(x1, x2 - 1, y1, y1, 1);
+        else if (x1 > x2)
+            fill(x2 + 1, x1, y1, y1, 1);
+        return;
+    }
+    if (x1 == x2)
+    {
+        if (y1 < y2)
+            fill(x1, x1, y1, y2 - 1, 1);
+        else
+            fill(x1, x1, y2 + 1, y1, 1);
+        return;
+    }
+
+    int16_t dx = x2 > x1 ? x2 - x1 : x1 - x2;
+    int16_t dy = y2 > y1 ? y1 - y2 : y2 - y1;
+    int8_t sx = x2 > x1 ? 1 : -1;
+    int8_t sy = y2 > y1 ? 1 : -1;
+    int16_t err = dx + dy;
+    uint8_t step = dx >= -dy ? dx : -dy;
+
+    while (step--)
+    {
+        nokia_lcd_set_pixel(x1, y1, 1);
+        int16_t e2 = 2 * err;
+        if (e2 >= dy)
+        {
+            err += dy;
+            x1 += sx;
+        }
+        if (e2 <= dx)
+        {
+            err += dx;
+            y1 += sy;
+        }
     }
 }
 
-// Desenha um retângulo (4 linhas)
+// Desenha um retângulo (2 spans horizontais e 2 verticais)
 void nokia_lcd_drawrect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2)
 {
-    nokia_lcd_drawline(x1, y1, x2, y1);
-    nokia_lcd_drawline(x2, y1, x2, y2);
-    nokia_lcd_drawline(x2, y2, x1, y2);
-    nokia_lcd_drawline(x1, y2, x1, y1);
+    nokia_lcd_hspan(x1, x2, y1, 1);
+    nokia_lcd_hspan(x1, x2, y2, 1);
+    nokia_lcd_vspan(x1, y1, y2, 1);
+    nokia_lcd_vspan(x2, y1, y2, 1);
 }
 
 // Desenha um círculo
@@ -280,6 +1490,7 @@ void nokia_lcd_drawcircle(uint8_t x0, uint8_t y0, uint8_t r)
     int y = 0;
     int err = 0;
 
+    RECORD(OVERLAY_CIRCLE, x0, y0, r, 0, 1, NULL);
     while (x >= y)
     {
         nokia_lcd_set_pixel(x0 + x, y0 + y, 1);
@@ -25,15 +25,54 @@
 
 /*
  * LCD's pins
+ *
+ * With LCD_SPI defined the hardware SPI peripheral drives the display, so
+ * DIN has to sit on MOSI (PB3) and DC moves to PB4. LCD_RST is on SS (PB2),
+ * which keeps the SPI in master mode as long as it stays an output.
  */
 #define LCD_SCE PB1
 #define LCD_RST PB2
+#ifdef LCD_SPI
+#define LCD_DC PB4
+#define LCD_DIN PB3
+#else
 #define LCD_DC PB3
 #define LCD_DIN PB4
+#endif
 #define LCD_CLK PB5
 
 #define LCD_CONTRAST 0x40
 
+/*
+ * With LCD_ASYNC defined frames are streamed by the SPI transfer complete
+ * interrupt from a second (front) buffer, so drawing can go on meanwhile
+ */
+#if defined(LCD_ASYNC) && !defined(LCD_SPI)
+#error "LCD_ASYNC needs the SPI transport (LCD_SPI)"
+#endif
+
+/*
+ * With LCD_TILES defined there is no 504 byte screen buffer. The screen is
+ * described instead by a background in program memory (nokia_lcd_load_P),
+ * a grid of 14x6 character cells, filled by scale 1 text written at x
+ * multiple of 6 and y multiple of 8, and a display list of overlays with
+ * everything else (shapes, sprites and the other texts). Render draws each
+ * bank from them into an 84 byte window on the stack as it is sent.
+ *
+ * Drawing the same sprite or text at the same place again updates its
+ * overlay instead of adding one; when the list or the text space is full,
+ * new drawings are dropped and counted (nokia_lcd_dropped). The list must
+ * hold the busiest screen of the application, which sets its size.
+ */
+#ifndef NOKIA_LCD_OVERLAYS
+#define NOKIA_LCD_OVERLAYS 16
+#endif
+#define NOKIA_LCD_TEXT 40
+
+#if defined(LCD_TILES) && defined(LCD_ASYNC)
+#error "LCD_TILES draws the banks while they are sent, it cannot be used with LCD_ASYNC"
+#endif
+
 /*
  * Must be called once before any other function, initializes display
  */
@@ -44,6 +83,13 @@ void nokia_lcd_init(void);
  */
 void nokia_lcd_clear(void);
 
+/**
+ * Replace the whole screen with an image from program memory (e.g. a
+ * background generated from backgrounds.txt) and move the cursor to 0
+ * @image: 504 bytes, in the layout of the screen (6 banks of 84 columns)
+ */
+void nokia_lcd_load_P(const uint8_t *image);
+
 /**
  * Power of display
  * @lcd: lcd nokia struct
@@ -69,6 +115,34 @@ void nokia_lcd_drawline(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
  */
 void nokia_lcd_drawrect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2);
 
+/**
+ * Preenche (ou apaga) um retângulo, cantos inclusos
+ * @x1: coord. x de um dos cantos
+ * @y1: coord. y de um dos cantos
+ * @x2: coord. x do outro canto
+ * @y2: coord. y do outro canto
+ * @value: 1 - acende; 0 - apaga;
+ */
+void nokia_lcd_fillrect(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, uint8_t value);
+
+/**
+ * Desenha (ou apaga) um span horizontal, extremos inclusos
+ * @x1: coord. x de uma das pontas
+ * @x2: coord. x da outra ponta
+ * @y: coord. y do span
+ * @value: 1 - acende; 0 - apaga;
+ */
+void nokia_lcd_hspan(uint8_t x1, uint8_t x2, uint8_t y, uint8_t value);
+
+/**
+ * Desenha (ou apaga) um span vertical, extremos inclusos
+ * @x: coord. x do span
+ * @y1: coord. y de uma das pontas
+ * @y2: coord. y da outra ponta
+ * @value: 1 - acende; 0 - apaga;
+ */
+void nokia_lcd_vspan(uint8_t x, uint8_t y1, uint8_t y2, uint8_t value);
+
 /**
  * Desenha um círculo
  * @x: coord. x do centro
@@ -85,6 +159,76 @@ void nokia_lcd_drawcircle(uint8_t x, uint8_t y, uint8_t r);
  */
 void nokia_lcd_set_pixel(uint8_t x, uint8_t y, uint8_t value);
 
+/*
+ * Sprite in program memory, up to 8 rows high. Each frame is one byte per
+ * column (bit 0 on top) followed by one mask byte per column, with the
+ * pixels the frame owns; the others are transparent and keep the screen.
+ */
+struct nokia_lcd_sprite
+{
+    uint8_t width;
+    const uint8_t *frames;
+};
+
+/**
+ * Draw a sprite frame at any height: each column is merged into the two
+ * banks it straddles
+ * @x: horizontal position of the left column
+ * @y: vertical position of the top row
+ * @sprite: sprite
+ * @frame: frame to draw
+ */
+void nokia_lcd_draw_sprite(uint8_t x, uint8_t y, const struct nokia_lcd_sprite *sprite, uint8_t frame);
+
+/*
+ * Proportional font in program memory, generated at build time (see
+ * host/fonttool.c) with one glyph per character from first to last. Each
+ * glyph has its own width; its columns are (height + 7) / 8 bytes, bit 0 of
+ * the first byte on top.
+ */
+struct nokia_lcd_font
+{
+    uint8_t height;
+    uint8_t spacing;
+    char first;
+    char last;
+    const uint8_t *widths;
+    const uint16_t *offsets;
+    const uint8_t *bitmap;
+};
+
+/**
+ * Draw single char with a proportional font at the cursor, which moves past
+ * the glyph and its spacing. The glyph box (spacing included) is cleared.
+ * @code: char code, characters out of the font are drawn as the first one
+ * @font: font
+ */
+void nokia_lcd_write_char_font(char code, const struct nokia_lcd_font *font);
+
+/**
+ * Draw string with a proportional font at the cursor. No wrapping is done:
+ * whatever goes past the right edge is clipped.
+ * @str: sending string
+ * @font: font
+ */
+void nokia_lcd_write_string_font(const char *str, const struct nokia_lcd_font *font);
+
+/**
+ * Width of a string written with a proportional font
+ * @str: string
+ * @font: font
+ * Return: columns taken, without the spacing after the last glyph;
+ */
+uint8_t nokia_lcd_string_width(const char *str, const struct nokia_lcd_font *font);
+
+/**
+ * Draw string with a proportional font, centered on the screen
+ * @str: sending string
+ * @y: vertical position
+ * @font: font
+ */
+void nokia_lcd_write_string_centered(const char *str, uint8_t y, const struct nokia_lcd_font *font);
+
 /**
  * Draw single char with 1-6 scale
  * @code: char code
@@ -107,10 +251,72 @@ void nokia_lcd_write_string(const char *str, uint8_t scale);
 void nokia_lcd_set_cursor(uint8_t x, uint8_t y);
 
 /*
- * Render screen to display
+ * Render screen to display. Only the columns changed since the last render
+ * are sent, one span per bank, using the X (0x80|x) and Y (0x40|bank)
+ * address commands.
  */
 void nokia_lcd_render(void);
 
+/**
+ * Render part of a bank: only the changed columns inside [x0, x1] are sent.
+ * Other areas of the screen keep their changes for a later render.
+ * With LCD_ASYNC they are sent in background, like nokia_lcd_render_async,
+ * once the frame already being sent is out.
+ * @bank: bank (0-5)
+ * @x0: first column
+ * @x1: last column
+ */
+void nokia_lcd_render_bank_span(uint8_t bank, uint8_t x0, uint8_t x1);
+
+/**
+ * Render a rectangle: the changed columns of the banks it covers, inside
+ * its columns, are sent (a bank is 8 rows high, so whole banks are sent).
+ * With LCD_ASYNC they are sent in background, like nokia_lcd_render_bank_span
+ * @x: horizontal position of the left column
+ * @y: vertical position of the top row
+ * @w: width
+ * @h: height
+ */
+void nokia_lcd_render_rect(uint8_t x, uint8_t y, uint8_t w, uint8_t h);
+
+/**
+ * Size of the last frame (rendered or started in background)
+ * Return: bytes sent to the display, commands included;
+ */
+uint16_t nokia_lcd_frame_bytes(void);
+
+/**
+ * Drawings dropped because the display list or its text space was full
+ * (LCD_TILES only, always 0 with the screen buffer)
+ * Return: how many since nokia_lcd_init, saturated at 255;
+ */
+uint8_t nokia_lcd_dropped(void);
+
+/*
+ * Mark the whole screen as changed, so the next render sends all of it
+ * (e.g. when the display RAM is not known to match the screen buffer)
+ */
+void nokia_lcd_invalidate(void);
+
+/**
+ * Copy the changed spans of the screen to the front buffer and send them in
+ * background.
+ * Without LCD_ASYNC this is the same as nokia_lcd_render().
+ * Return: 1 - frame started; 0 - previous frame still being sent, nothing done;
+ */
+uint8_t nokia_lcd_render_async(void);
+
+/**
+ * Background render state
+ * Return: 1 - a frame is being sent; 0 - display idle;
+ */
+uint8_t nokia_lcd_busy(void);
+
+/*
+ * Wait until the frame being sent in background is complete
+ */
+void nokia_lcd_flush(void);
+
 /*
  * Define custom char (ASCII 0-31)
  */
@@ -0,0 +1,67 @@
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "prof.h"
+#include "ticks.h"
+#include "telemetry.h"
+
+#ifdef PROFILE
+
+static struct prof_stat stats[PROF_COUNT];
+
+static const char names[PROF_COUNT][4] PROGMEM = { "TBL", "FLD", "FMT", "LCD" };
+
+void prof_end(struct prof_scope *scope)
+{
+    uint16_t end = prof_counts();
+    uint16_t counts = end - scope->start;
+    if (end < scope->start) // Timer 1 reached TICK_COUNTS and restarted from 0
+        counts += TICK_COUNTS;
+
+    struct prof_stat *stat = &stats[scope->probe];
+    if (counts < stat->min)
+        stat->min = counts;
+    if (counts > stat->max)
+        stat->max = counts;
+    stat->sum += counts;
+    stat->count++;
+}
+
+void prof_reset()
+{
+    for (uint8_t i = 0; i < PROF_COUNT; i++)
+    {
+        stats[i].min = 0xFFFF;
+        stats[i].max = 0;
+        stats[i].sum = 0;
+        stats[i].count = 0;
+    }
+}
+
+const struct prof_stat *prof_get(const uint8_t PROBE)
+{
+    return &stats[PROBE];
+}
+
+const char *prof_name(const uint8_t PROBE)
+{
+    return names[PROBE];
+}
+
+void prof_dump()
+{
+    for (uint8_t i = 0; i < PROF_COUNT; i++)
+    {
+        const struct prof_stat *stat = &stats[i];
+        uint8_t record[] =
+        {
+            i,
+            stat->min & 0xFF, stat->min >> 8,
+            stat->max & 0xFF, stat->max >> 8,
+            stat->count & 0xFF, stat->count >> 8,
+            stat->sum & 0xFF, (stat->sum >> 8) & 0xFF, (stat->sum >> 16) & 0xFF, stat->sum >> 24
+        };
+        telemetry_send(TELEMETRY_PROF, record, sizeof(record));
+    }
+}
+
+#endif
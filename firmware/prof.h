@@ -0,0 +1,92 @@
+#ifndef __PROF_H__
+#define __PROF_H__
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include <stdint.h>
+
+/**
+ * Scoped profiler: PROF_SCOPE(probe) at the start of a block times the rest of the block, from TCNT1 at the macro to TCNT1 when
+ * the block is left (by any path), and keeps min/max/sum/count per probe. Timer 1 counts (4 us) are used as they are, so a
+ * probe must be shorter than one tick (1/IRQ_FREQ s); the timer wrapping once is accounted for. Probes must not be used in
+ * interruption routines.
+ *
+ * Only built with PROFILE defined (make PROFILE=1); otherwise the macro and the functions compile to nothing.
+ */
+
+enum prof_probe
+{
+    PROF_RENDER_TABLE,    // render_table()
+    PROF_RENDER_FIELDS,   // render_timer_points_misses()
+    PROF_FORMAT,          // fmt_u16()
+    PROF_LCD_RENDER,      // nokia_lcd_render_rect() of the render tasks
+    PROF_COUNT
+};
+
+struct prof_stat
+{
+    uint16_t min;     // Timer 1 counts
+    uint16_t max;     // Timer 1 counts
+    uint32_t sum;     // Timer 1 counts
+    uint16_t count;
+};
+
+#ifdef PROFILE
+struct prof_scope
+{
+    uint8_t probe;
+    uint16_t start;
+};
+
+#define PROF_SCOPE(PROBE) \
+    struct prof_scope prof_scope_##PROBE __attribute__((cleanup(prof_end))) = { PROBE, prof_counts() }
+
+/**
+ * Reads TCNT1. Its two bytes go through the TEMP register of Timer 1, which an interruption routine reading the timer (e.g. with
+ * ticks_stamp()) between them would overwrite, so the read is atomic.
+ * @return Timer 1 counts since the last tick
+ */
+static inline uint16_t prof_counts()
+{
+    uint16_t counts;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        counts = TCNT1;
+    }
+    return counts;
+}
+
+/**
+ * Ends a scope, called by the compiler when the scope is left.
+ * @param scope the scope
+ */
+void prof_end(struct prof_scope *scope);
+
+/**
+ * Clears the statistics of all the probes.
+ */
+void prof_reset();
+
+/**
+ * @param PROBE the probe
+ * @return the statistics of the probe
+ */
+const struct prof_stat *prof_get(const uint8_t PROBE);
+
+/**
+ * @param PROBE the probe
+ * @return the short name of the probe (3 characters), in program memory
+ */
+const char *prof_name(const uint8_t PROBE);
+
+/**
+ * Sends the statistics of all the probes as telemetry records (TELEMETRY_PROF), if the telemetry is on.
+ */
+void prof_dump();
+#else
+#define PROF_SCOPE(PROBE)
+static inline void prof_reset() {}
+static inline void prof_dump() {}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+#include <avr/io.h>
+#include "rng.h"
+
+#define ADC_SAMPLES   16   // conversions folded into the seed
+
+static uint16_t state = 0xACE1;
+
+void rng_seed(const uint16_t SEED)
+{
+    state ^= SEED;
+    if (!state)
+        state = 0xACE1;
+    rng_next();
+}
+
+void rng_seed_adc()
+{
+    uint16_t seed = 0;
+    ADMUX = (1 << REFS1) | (1 << REFS0) | (1 << MUX3);  // internal 1.1 V reference, temperature sensor
+    ADCSRA = (1 << ADEN) | (1 << ADPS1);                // clock / 4: far past the rated 200 kHz, so the low bits are noisier
+    for (uint8_t i = 0; i < ADC_SAMPLES; i++)
+    {
+        ADCSRA |= 1 << ADSC;
+        while (ADCSRA & (1 << ADSC))
+            ;
+        seed = (seed << 3 | seed >> 13) ^ ADC;           // rotated, so each conversion lands its low bits somewhere else
+    }
+    ADCSRA = 0;                                         // the ADC draws current while enabled
+    rng_seed(seed);
+}
+
+uint16_t rng_next()
+{
+    state ^= state << 7;
+    state ^= state >> 9;
+    state ^= state << 8;
+    return state;
+}
+
+uint8_t rng_below(const uint8_t N)
+{
+    return ((uint32_t) rng_next() * N) >> 16;
+}
@@ -0,0 +1,36 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stdint.h>
+
+/**
+ * Random numbers for the game: a 16-bit xorshift generator (period 2^16 - 1) that costs a fixed handful of shifts and xors per
+ * number, instead of the 32-bit multiplications of avr-libc rand(). It is seeded from the noise of the ADC.
+ */
+
+/**
+ * Mixes a value into the state of the generator (the state never becomes 0).
+ * @param SEED the value
+ */
+void rng_seed(const uint16_t SEED);
+
+/**
+ * Seeds the generator from the least significant bits of fast conversions of the internal temperature sensor, which are noise.
+ * Takes about 0.1 ms; the ADC is off again when it returns.
+ */
+void rng_seed_adc();
+
+/**
+ * Next number of the sequence.
+ * @return a number from 1 to 65535
+ */
+uint16_t rng_next();
+
+/**
+ * Random number below a limit, by scaling a 16-bit number (no division and no retries; the bias is under N / 65536).
+ * @param N the limit (1 or more)
+ * @return a number from 0 to N - 1
+ */
+uint8_t rng_below(const uint8_t N);
+
+#endif
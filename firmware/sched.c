@@ -0,0 +1,150 @@
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "sched.h"
+#include "ticks.h"
+
+static bool running = false;
+static uint16_t wake_count = 0;        // how many times the MCU woke up from sleep
+static uint32_t awake_counts = 0;      // how long the MCU was awake, in Timer 1 counts
+static uint32_t last_wake_stamp = 0;   // ticks_stamp() of the last wake up
+static uint32_t loops = 0;             // iterations of the scheduler loop
+static uint8_t (*events_pending)() = 0;
+static uint8_t (*clocks_busy)() = 0;
+
+/**
+ * @return non-zero if the application has events waiting
+ */
+static uint8_t events_waiting()
+{
+    return events_pending && events_pending();
+}
+
+/**
+ * Releases the task if its period is up, keeping the releases on the tick grid. A task that starts a whole period late has its
+ * missed releases counted as overruns instead of running them back to back.
+ * @return true if the task was released
+ */
+static bool release(struct sched_task *task, const uint16_t NOW)
+{
+    uint16_t late = NOW - task->next;
+    if (late >= 0x8000)  // next is still in the future
+        return false;
+
+    if (late >= task->period)
+    {
+        task->overruns += late / task->period;
+        task->next = NOW + task->period;
+    }
+    else
+        task->next += task->period;
+    return true;
+}
+
+void sched_set_pending(uint8_t (*pending)())
+{
+    events_pending = pending;
+}
+
+void sched_set_busy(uint8_t (*busy)())
+{
+    clocks_busy = busy;
+}
+
+void sched_run(struct sched_task *tasks, const uint8_t count)
+{
+    uint16_t now = ticks_now();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        tasks[i].next = now;
+        tasks[i].max_runtime = 0;
+        tasks[i].overruns = 0;
+    }
+    wake_count = 0;
+    awake_counts = 0;
+    loops = 0;
+    last_wake_stamp = ticks_stamp();
+
+    uint16_t last_tick = now;
+    running = true;
+    while (running)
+    {
+        loops++;
+        now = ticks_now();
+
+        // the highest priority task that is due, or ready
+        struct sched_task *task = 0;
+        for (uint8_t i = 0; i < count && !task; i++)
+            if (release(&tasks[i], now) || (tasks[i].ready && tasks[i].ready()))
+                task = &tasks[i];
+
+        if (!task)
+        {
+            last_tick = now;
+            sched_sleep(last_tick);
+            continue;
+        }
+
+        uint32_t start = ticks_stamp();
+        task->run();
+        uint32_t runtime = ticks_stamp() - start;
+        if (runtime > task->max_runtime)
+            task->max_runtime = runtime > 0xFFFF ? 0xFFFF : runtime;
+    }
+}
+
+void sched_stop()
+{
+    running = false;
+}
+
+void sched_sleep(const uint16_t LAST_TICK)
+{
+    uint32_t sleep_stamp = ticks_stamp();
+    awake_counts += sleep_stamp - last_wake_stamp;
+
+    // interruptions that bring no work (debounce timer, SPI bytes) just put the MCU back to sleep
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    while (ticks_now() == LAST_TICK && !events_waiting())
+    {
+        sleep_enable();
+        sei();       // the instruction after sei() always runs before any interruption, so the wake up cannot be missed
+        sleep_cpu();
+        sleep_disable();
+        wake_count++;
+        cli();
+    }
+    sei();
+
+    last_wake_stamp = ticks_stamp();
+}
+
+void sched_power_down()
+{
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    cli();
+    if (!events_waiting() && !(clocks_busy && clocks_busy()))
+    {
+        sleep_enable();
+        sleep_bod_disable(); // the brown-out detector is off while asleep, it must be done right before sleep_cpu()
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    sei();
+}
+
+uint16_t sched_wakes()
+{
+    return wake_count;
+}
+
+uint32_t sched_awake()
+{
+    return awake_counts;
+}
+
+uint32_t sched_loops()
+{
+    return loops;
+}
@@ -0,0 +1,80 @@
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * A task of the cooperative scheduler. Tasks run to completion, highest priority first: the position in the task table is the
+ * priority (index 0 is the highest).
+ */
+struct sched_task
+{
+    void (*run)();            // task body
+    uint8_t (*ready)();       // optional, makes the task run before its period is up (e.g. input waiting), NULL if not used
+    uint16_t period;          // in ticks
+
+    // kept by the scheduler
+    uint16_t next;            // tick of the next periodic release
+    uint16_t max_runtime;     // longest run so far, in Timer 1 counts
+    uint16_t overruns;        // releases that were skipped because the task started a whole period (or more) late
+};
+
+/**
+ * Sets how the sleep functions know that events are waiting (e.g. button events in a queue filled by interruption routines):
+ * the MCU is not put to sleep while there are, and goes back to work when an interruption brings one. It is called with the
+ * interruptions disabled.
+ * @param pending returns non-zero while events are waiting, NULL if the application has none
+ */
+void sched_set_pending(uint8_t (*pending)());
+
+/**
+ * Sets how sched_power_down() knows that something still needs the clocks that power-down stops (e.g. a timer that times a
+ * debounce window, or an EEPROM write whose interruption cannot wake the MCU up). It is called with the interruptions disabled.
+ * @param busy returns non-zero while the MCU must stay awake, NULL if nothing needs it
+ */
+void sched_set_busy(uint8_t (*busy)());
+
+/**
+ * Runs the tasks until sched_stop() is called, sleeping in idle mode while no task is due. The tasks are released for the first
+ * time right away, and the counters of the tasks and of the scheduler are reset.
+ * @param tasks the task table, in priority order
+ * @param count how many tasks there are in the table
+ */
+void sched_run(struct sched_task *tasks, const uint8_t count);
+
+/**
+ * Makes sched_run() return once the running task is done.
+ */
+void sched_stop();
+
+/**
+ * Puts the MCU to sleep in idle mode until an interruption arrives (Timer 1, Timer 2, the pin change interruption and the SPI
+ * keep running), unless the tick has already moved past LAST_TICK or an event is waiting (see sched_set_pending()).
+ * @param LAST_TICK the last tick the caller has handled
+ */
+void sched_sleep(const uint16_t LAST_TICK);
+
+/**
+ * Puts the MCU to sleep in power-down mode (only the pin change interruption can wake it up), unless an event is waiting or
+ * something needs the clocks (see sched_set_busy()). Timer 1 stops as well, so the ticks do not move while asleep.
+ * Anything else that needs the clock (e.g. a frame being sent to the LCD) must be finished by the caller.
+ */
+void sched_power_down();
+
+/**
+ * @return how many times the MCU woke up since sched_run() started
+ */
+uint16_t sched_wakes();
+
+/**
+ * @return how long the MCU was awake since sched_run() started, in Timer 1 counts
+ */
+uint32_t sched_awake();
+
+/**
+ * @return how many times the scheduler loop ran (a task or a sleep) since sched_run() started
+ */
+uint32_t sched_loops();
+
+#endif
@@ -0,0 +1,318 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <gelf.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_interrupts.h"
+#include "avr_ioport.h"
+
+/**
+ * Runs the firmware (code.elf) under simavr, playing the game with scripted button presses, and reports how many CPU cycles the
+ * render functions and the Timer 1 interruption take. The results are compared with a baseline file: a metric more than
+ * TOLERANCE_PCT worse than its baseline fails the run.
+ *
+ * Usage: bench ELF BASELINE [--update], with --update the baseline file is (re)written with the results instead. A metric
+ * missing from the baseline file fails the run too. Without a baseline file (none recorded yet) the results are only shown.
+ *
+ * The build configuration is read from the ELF: the buttons are on PD2 on when the telemetry is built in (telemetry_send is
+ * there), and moles_up is as wide as its symbol. The keypad boards (BOARD=9 or 16, BOARD_LAYOUT holds more than 5 wholes) are
+ * not supported, their matrix scan is not simulated.
+ */
+
+#define F_CPU                   16000000
+#define TIMER1_COMPA_VECT_NUM   11        // ATmega328P
+#define TOLERANCE_PCT           5
+
+#define START_PRESS_MS          200       // when W is pressed on the title screen
+#define PLAY_SECONDS            10        // simulated seconds of play after W is pressed
+#define PRESS_PERIOD_MS         120       // a button is pressed this often while playing
+#define PRESS_HOLD_MS           40
+
+#define BUTTONS                 5         // W, A, S, D and X, active low
+
+#define MS_TO_CYCLES(ms)        ((avr_cycle_count_t) (ms) * (F_CPU / 1000))
+
+/**
+ * Cycle statistics of a measured event.
+ */
+struct cycle_stat
+{
+    uint32_t count;
+    uint64_t sum;
+    uint32_t max;
+};
+
+/**
+ * A function measured from its entry (PC at its address) to its return (SP back above the return address).
+ */
+struct probe
+{
+    const char *symbol;
+    uint32_t address;           // byte address in flash
+    uint16_t sp;                // SP at the entry, 0 when the function is not running
+    avr_cycle_count_t start;
+    struct cycle_stat cycles;
+};
+
+static struct probe probes[] =
+{
+    { "render_table" },
+    { "render_timer_points_misses" },
+};
+
+static struct cycle_stat isr_latency;   // from the compare match to the first instruction of the vector
+static struct cycle_stat isr_duration;  // from the vector to reti
+static avr_cycle_count_t isr_pending_cycle, isr_running_cycle;
+static avr_t *avr;
+static uint8_t button_pin0;             // PD pin of button 0
+
+static void stat_add(struct cycle_stat *stat, const uint32_t VALUE)
+{
+    stat->count++;
+    stat->sum += VALUE;
+    if (VALUE > stat->max)
+        stat->max = VALUE;
+}
+
+static uint32_t stat_avg(const struct cycle_stat *stat)
+{
+    return stat->count ? stat->sum / stat->count : 0;
+}
+
+/**
+ * Looks a symbol up in the symbol table of the ELF file.
+ * @param size where the size of the symbol is stored, in bytes (NULL if not needed)
+ * @return the value of the symbol (a byte address for code, 0x800000 + address for data), or 0 if it is not there
+ */
+static uint32_t elf_symbol(const char *path, const char *name, uint32_t *size)
+{
+    uint32_t value = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    elf_version(EV_CURRENT);
+    Elf *elf = elf_begin(fd, ELF_C_READ, NULL);
+    Elf_Scn *scn = NULL;
+    while (elf && !value && (scn = elf_nextscn(elf, scn)))
+    {
+        GElf_Shdr shdr;
+        if (!gelf_getshdr(scn, &shdr) || shdr.sh_type != SHT_SYMTAB)
+            continue;
+        Elf_Data *data = elf_getdata(scn, NULL);
+        for (size_t i = 0; data && i < shdr.sh_size / shdr.sh_entsize; i++)
+        {
+            GElf_Sym sym;
+            if (gelf_getsym(data, i, &sym) && !strcmp(elf_strptr(elf, shdr.sh_link, sym.st_name), name))
+            {
+                value = sym.st_value;
+                if (size)
+                    *size = sym.st_size;
+                break;
+            }
+        }
+    }
+    if (elf)
+        elf_end(elf);
+    close(fd);
+    return value;
+}
+
+static void timer1_pending(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    if (value)
+        isr_pending_cycle = avr->cycle;
+}
+
+static void timer1_running(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+    if (value)
+    {
+        isr_running_cycle = avr->cycle;
+        stat_add(&isr_latency, isr_running_cycle - isr_pending_cycle);
+    }
+    else
+        stat_add(&isr_duration, avr->cycle - isr_running_cycle);
+}
+
+static uint16_t sp()
+{
+    return avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+}
+
+static void probe_step(struct probe *probe)
+{
+    if (probe->sp && sp() > probe->sp)  // returned, the return address was popped
+    {
+        stat_add(&probe->cycles, avr->cycle - probe->start);
+        probe->sp = 0;
+    }
+    if (!probe->sp && avr->pc == probe->address)
+    {
+        probe->sp = sp();
+        probe->start = avr->cycle;
+    }
+}
+
+/**
+ * Presses (or releases) a button: the buttons are active low, on PD(button_pin0) on.
+ */
+static void button(const uint8_t BUTTON, const bool PRESSED)
+{
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), button_pin0 + BUTTON), !PRESSED);
+}
+
+/**
+ * One line of the report. The metric is compared with the baseline value (lower is better, unless HIGHER_IS_BETTER).
+ * @return true if the metric is within the tolerance
+ */
+static bool report(FILE *baseline, FILE *update, const char *name, const uint32_t VALUE, const bool HIGHER_IS_BETTER)
+{
+    if (update)
+    {
+        fprintf(update, "%s %u\n", name, (unsigned) VALUE);
+        printf("%-32s %10u\n", name, (unsigned) VALUE);
+        return true;
+    }
+
+    // the baseline file is small, a linear scan per metric is fine
+    char line[96], key[64];
+    unsigned base = 0;
+    bool found = false;
+    if (baseline)
+        rewind(baseline);
+    while (baseline && !found && fgets(line, sizeof(line), baseline))
+        found = sscanf(line, "%63s %u", key, &base) == 2 && !strcmp(key, name);
+
+    bool ok = found && (HIGHER_IS_BETTER ? VALUE * 100ULL >= base * (100ULL - TOLERANCE_PCT)
+                                          : VALUE * 100ULL <= base * (100ULL + TOLERANCE_PCT));
+    if (found)
+        printf("%-32s %10u %10u%s\n", name, (unsigned) VALUE, base, ok ? "" : "  REGRESSION");
+    else
+        printf("%-32s %10u %10s  NO BASELINE\n", name, (unsigned) VALUE, "-");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s ELF BASELINE [--update]\n", argv[0]);
+        return 2;
+    }
+    bool update = argc > 3 && !strcmp(argv[3], "--update");
+
+    for (uint8_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++)
+        if (!(probes[i].address = elf_symbol(argv[1], probes[i].symbol, NULL)))
+        {
+            fprintf(stderr, "%s: no symbol %s\n", argv[1], probes[i].symbol);
+            return 2;
+        }
+    uint32_t moles_up_size = 0, layout_size = 0;
+    uint32_t moles_up = elf_symbol(argv[1], "moles_up", &moles_up_size) & 0xFFFF; // data address
+    if (!moles_up || !moles_up_size || moles_up_size > 2)
+    {
+        fprintf(stderr, "%s: no symbol moles_up, or not 1 or 2 bytes\n", argv[1]);
+        return 2;
+    }
+    if (!elf_symbol(argv[1], "BOARD_LAYOUT", &layout_size) || layout_size != 2 * BUTTONS)
+    {
+        fprintf(stderr, "%s: only the board of %d buttons is supported (make BOARD=5)\n", argv[1], BUTTONS);
+        return 2;
+    }
+    button_pin0 = elf_symbol(argv[1], "telemetry_send", NULL) ? 2 : 0; // PD1 is TXD with the telemetry on
+
+    elf_firmware_t firmware = {{0}};
+    if (elf_read_firmware(argv[1], &firmware))
+    {
+        fprintf(stderr, "%s: cannot be loaded\n", argv[1]);
+        return 2;
+    }
+    avr = avr_make_mcu_by_name("atmega328p");
+    avr_init(avr);
+    firmware.frequency = F_CPU;
+    avr_load_firmware(avr, &firmware);
+
+    avr_irq_t *timer1 = avr_get_interrupt_irq(avr, TIMER1_COMPA_VECT_NUM);
+    avr_irq_register_notify(timer1 + AVR_INT_IRQ_PENDING, timer1_pending, NULL);
+    avr_irq_register_notify(timer1 + AVR_INT_IRQ_RUNNING, timer1_running, NULL);
+
+    for (uint8_t b = 0; b < BUTTONS; b++)
+        button(b, false);
+
+    // title screen, then W, then the game with a press every PRESS_PERIOD_MS, every other one on the mole
+    avr_cycle_count_t start = MS_TO_CYCLES(START_PRESS_MS);
+    avr_cycle_count_t end = start + MS_TO_CYCLES(PLAY_SECONDS * 1000);
+    avr_cycle_count_t next_press = start, next_release = 0;
+    uint32_t presses = 0;
+    uint8_t pressed = 0;
+    while (avr->cycle < end)
+    {
+        int state = avr_run(avr);
+        if (state == cpu_Done || state == cpu_Crashed)
+        {
+            fprintf(stderr, "the simulation stopped at cycle %llu\n", (unsigned long long) avr->cycle);
+            return 2;
+        }
+        for (uint8_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++)
+            probe_step(&probes[i]);
+
+        if (next_release && avr->cycle >= next_release)
+        {
+            button(pressed, false);
+            next_release = 0;
+        }
+        if (avr->cycle >= next_press)
+        {
+            uint16_t up = avr->data[moles_up]; // the lowest whole with a mole out (moles_up is little endian)
+            if (moles_up_size > 1)
+                up |= avr->data[moles_up + 1] << 8;
+            uint8_t mole = 0;
+            while (mole < BUTTONS - 1 && !(up >> mole & 1))
+                mole++;
+            pressed = presses == 0 ? 0 : (presses & 1) ? mole : (mole + 1) % BUTTONS;
+            button(pressed, true);
+            next_release = avr->cycle + MS_TO_CYCLES(PRESS_HOLD_MS);
+            next_press = avr->cycle + MS_TO_CYCLES(PRESS_PERIOD_MS);
+            presses++;
+        }
+    }
+
+    FILE *baseline = fopen(argv[2], update ? "w" : "r");
+    if (!baseline && update)
+    {
+        perror(argv[2]);
+        return 2;
+    }
+    if (!baseline)
+        printf("%s: no baseline yet, nothing is compared (make bench-baseline records one)\n", argv[2]);
+    FILE *out = update ? baseline : NULL;
+    FILE *in = update ? NULL : baseline;
+
+    bool ok = true;
+    printf("%-32s %10s %10s\n", "metric (cycles)", "result", "baseline");
+    for (uint8_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "%s.avg", probes[i].symbol);
+        ok &= report(in, out, name, stat_avg(&probes[i].cycles), false);
+        snprintf(name, sizeof(name), "%s.max", probes[i].symbol);
+        ok &= report(in, out, name, probes[i].cycles.max, false);
+    }
+    ok &= report(in, out, "timer1_isr.latency.avg", stat_avg(&isr_latency), false);
+    ok &= report(in, out, "timer1_isr.latency.max", isr_latency.max, false);
+    ok &= report(in, out, "timer1_isr.duration.avg", stat_avg(&isr_duration), false);
+    ok &= report(in, out, "timer1_isr.duration.max", isr_duration.max, false);
+    // render_table() is called once per game frame
+    ok &= report(in, out, "frames_per_second", probes[0].cycles.count / PLAY_SECONDS, true);
+
+    if (baseline)
+        fclose(baseline);
+    return ok || !baseline ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#include <avr/pgmspace.h>
+#include "sprites.h"
+#include "ticks.h"
+
+#define FRAME_TICKS  MS_TO_TICKS(50)
+
+enum
+{
+    MOLE_EMPTY,
+    MOLE_PEEK,
+    MOLE_HALF,
+    MOLE_UP,
+    MOLE_HIT
+};
+
+// each frame: 8 columns (bit 0 on top), then the 8 mask columns
+static const uint8_t MOLE_FRAMES[] PROGMEM =
+{
+    0x80, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0x80,   // empty
+    0xFF, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF,
+    0x80, 0xE0, 0xD0, 0xD0, 0xD0, 0xD0, 0xE0, 0x80,   // peek
+    0xFF, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF,
+    0xB0, 0xC8, 0xD4, 0xC4, 0xC4, 0xD4, 0xC8, 0xB0,   // half
+    0xFF, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF,
+    0x9C, 0xE2, 0xC5, 0xD1, 0xD1, 0xC5, 0xE2, 0x9C,   // up
+    0xFF, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF,
+    0x9D, 0xE2, 0xD5, 0xC9, 0xC9, 0xD5, 0xE2, 0x9D,   // hit
+    0xFF, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF,
+};
+
+const struct nokia_lcd_sprite MOLE = { 8, MOLE_FRAMES };
+
+static const uint8_t HOLE_SEQUENCE[] PROGMEM = { MOLE_EMPTY };
+static const uint8_t POPUP_SEQUENCE[] PROGMEM = { MOLE_PEEK, MOLE_HALF, MOLE_UP };
+static const uint8_t WHACKED_SEQUENCE[] PROGMEM = { MOLE_HIT, MOLE_HIT, MOLE_HIT, MOLE_HALF, MOLE_PEEK, MOLE_EMPTY };
+static const uint8_t RETREAT_SEQUENCE[] PROGMEM = { MOLE_HALF, MOLE_PEEK, MOLE_EMPTY };
+
+const struct anim MOLE_HOLE = { &MOLE, HOLE_SEQUENCE, sizeof(HOLE_SEQUENCE), FRAME_TICKS };
+const struct anim MOLE_POPUP = { &MOLE, POPUP_SEQUENCE, sizeof(POPUP_SEQUENCE), FRAME_TICKS };
+const struct anim MOLE_WHACKED = { &MOLE, WHACKED_SEQUENCE, sizeof(WHACKED_SEQUENCE), FRAME_TICKS };
+const struct anim MOLE_RETREAT = { &MOLE, RETREAT_SEQUENCE, sizeof(RETREAT_SEQUENCE), FRAME_TICKS };
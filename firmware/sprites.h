@@ -0,0 +1,21 @@
+#ifndef __SPRITES_H__
+#define __SPRITES_H__
+
+#include "nokia5110.h"
+#include "anim.h"
+
+/**
+ * The mole, 8x8: an empty hole, the mole coming out (2 frames), the mole out and the mole whacked. All the frames own the same
+ * pixels, so any frame fully replaces any other.
+ */
+extern const struct nokia_lcd_sprite MOLE;
+
+/**
+ * Animations of a hole.
+ */
+extern const struct anim MOLE_HOLE;       // empty hole
+extern const struct anim MOLE_POPUP;      // the mole comes out and stays out
+extern const struct anim MOLE_WHACKED;    // the mole is hit and goes back in
+extern const struct anim MOLE_RETREAT;    // the mole goes back in
+
+#endif
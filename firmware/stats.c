@@ -0,0 +1,100 @@
+#include <string.h>
+#include "stats.h"
+
+#define BIN_UNITS  (65536UL / STATS_BINS)  // units per bin of the histogram
+
+/**
+ * Integer square root, a bit of the root at a time.
+ * @param VALUE the number
+ * @return the largest root whose square is not above VALUE
+ */
+static uint16_t isqrt(const uint32_t VALUE)
+{
+    uint16_t root = 0;
+    for (uint16_t bit = 0x8000; bit; bit >>= 1)
+    {
+        uint16_t trial = root | bit;
+        if ((uint32_t) trial * trial <= VALUE)
+            root = trial;
+    }
+    return root;
+}
+
+void stats_reset(struct stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void stats_add(struct stats *stats, const uint32_t US)
+{
+    uint32_t units = US / STATS_UNIT_US;
+    uint16_t sample = units > 0xFFFF ? 0xFFFF : units;
+
+    if (!stats->count || sample < stats->min)
+        stats->min = sample;
+    if (sample > stats->max)
+        stats->max = sample;
+    uint8_t *bin = &stats->bins[sample / BIN_UNITS];
+    if (*bin < 0xFF)
+        (*bin)++;
+    stats->count++;
+
+    // Welford: the mean moves 1/n of the way to the sample, and the variance 1/n of the way to the product of the distances
+    // of the sample to the old and to the new mean (both on the same side, so the product is never negative)
+    int32_t before_q8 = ((uint32_t) sample << 8) - stats->mean_q8;
+    stats->mean_q8 += before_q8 / (int32_t) stats->count;
+    int32_t after_q8 = ((uint32_t) sample << 8) - stats->mean_q8;
+    uint32_t before = ((before_q8 < 0 ? -before_q8 : before_q8) + 0x80) >> 8;
+    uint32_t after = ((after_q8 < 0 ? -after_q8 : after_q8) + 0x80) >> 8;
+    uint32_t product = before * after; // below 2^32, the distances are below 2^16 units
+    if (product >= stats->variance)
+        stats->variance += (product - stats->variance) / stats->count;
+    else
+        stats->variance -= (stats->variance - product) / stats->count;
+}
+
+uint32_t stats_min(const struct stats *stats)
+{
+    return (uint32_t) stats->min * STATS_UNIT_US;
+}
+
+uint32_t stats_max(const struct stats *stats)
+{
+    return (uint32_t) stats->max * STATS_UNIT_US;
+}
+
+uint32_t stats_mean(const struct stats *stats)
+{
+    return (stats->mean_q8 * STATS_UNIT_US + 0x80) >> 8;
+}
+
+uint32_t stats_sd(const struct stats *stats)
+{
+    return (uint32_t) isqrt(stats->variance) * STATS_UNIT_US;
+}
+
+uint32_t stats_quantile(const struct stats *stats, const uint8_t PERCENT)
+{
+    // the samples in the histogram (a bin may have saturated) and the rank of the quantile among them, from 1
+    uint16_t total = 0;
+    for (uint8_t i = 0; i < STATS_BINS; i++)
+        total += stats->bins[i];
+    if (!total)
+        return 0;
+    uint16_t rank = ((uint32_t) total * PERCENT + 99) / 100;
+    if (!rank)
+        rank = 1;
+
+    uint8_t bin = 0;
+    uint16_t below = 0;
+    while (below + stats->bins[bin] < rank)
+        below += stats->bins[bin++];
+
+    // the rank-th sample is in the middle of its share of the bin
+    uint32_t units = bin * BIN_UNITS + (2 * (rank - below) - 1) * BIN_UNITS / (2 * stats->bins[bin]);
+    if (units < stats->min)
+        units = stats->min;
+    if (units > stats->max)
+        units = stats->max;
+    return units * STATS_UNIT_US;
+}
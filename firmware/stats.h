@@ -0,0 +1,72 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdint.h>
+
+/**
+ * Streaming statistics of durations (the reaction times of a game): count, min, max, mean, variance and approximate quantiles,
+ * updated in fixed point as each sample arrives, without keeping the samples. The mean and the variance are updated with
+ * Welford's method; the quantiles are read from a histogram, interpolated inside the bin they fall in.
+ *
+ * Samples are kept in units of STATS_UNIT_US, up to 65535 units (about 2.1 s); longer ones count as 65535.
+ */
+#define STATS_UNIT_US   32                        // resolution of the samples
+#define STATS_BINS      32                        // bins of the histogram, 2048 units (65.5 ms) each
+
+struct stats
+{
+    uint16_t count;
+    uint16_t min;                 // units
+    uint16_t max;                 // units
+    uint32_t mean_q8;             // units, Q24.8
+    uint32_t variance;            // units^2 (population variance)
+    uint8_t bins[STATS_BINS];     // samples per bin, saturated at 255
+};
+
+/**
+ * Empties the statistics.
+ * @param stats the statistics
+ */
+void stats_reset(struct stats *stats);
+
+/**
+ * Adds a sample.
+ * @param stats the statistics
+ * @param US the sample, in microseconds
+ */
+void stats_add(struct stats *stats, const uint32_t US);
+
+/**
+ * @param stats the statistics
+ * @return the shortest sample, in microseconds (0 without samples)
+ */
+uint32_t stats_min(const struct stats *stats);
+
+/**
+ * @param stats the statistics
+ * @return the longest sample, in microseconds (0 without samples)
+ */
+uint32_t stats_max(const struct stats *stats);
+
+/**
+ * @param stats the statistics
+ * @return the mean, in microseconds (0 without samples)
+ */
+uint32_t stats_mean(const struct stats *stats);
+
+/**
+ * @param stats the statistics
+ * @return the standard deviation, in microseconds (0 without samples)
+ */
+uint32_t stats_sd(const struct stats *stats);
+
+/**
+ * Approximate quantile: the sample of the given rank is placed inside its bin as if the samples of the bin were evenly spread,
+ * and kept between the min and the max.
+ * @param stats the statistics
+ * @param PERCENT which quantile (50 for the median)
+ * @return the quantile, in microseconds (0 without samples)
+ */
+uint32_t stats_quantile(const struct stats *stats, const uint8_t PERCENT);
+
+#endif
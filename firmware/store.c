@@ -0,0 +1,157 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stddef.h>
+#include <string.h>
+#include "store.h"
+
+#define STORE_BASE    0       // EEPROM address of the first slot
+#define STORE_SLOTS   32      // slots of the ring: 32 * 18 bytes
+#define SEQ_ERASED    0xFF    // sequence byte of a slot never written, never used by a record
+#define CHECK_SEED    0x5A
+
+struct record
+{
+    uint8_t seq;                // sequence number, 0 to 0xFE
+    struct store_stats stats;
+    uint8_t check;              // checksum of the bytes before it, written last
+};
+
+static struct store_stats stats;
+static uint8_t last_slot = STORE_SLOTS - 1;     // slot and sequence number of the newest record
+static uint8_t last_seq = SEQ_ERASED - 1;       // (so the first record goes to slot 0 with number 0)
+
+static struct record pending;                   // record being written by the interruption routine
+static uint16_t pending_address;
+static volatile uint8_t written = sizeof(pending);
+
+static inline uint16_t slot_address(const uint8_t SLOT)
+{
+    return STORE_BASE + SLOT * sizeof(struct record);
+}
+
+static inline uint8_t next_seq(const uint8_t SEQ)
+{
+    return SEQ == SEQ_ERASED - 1 ? 0 : SEQ + 1;
+}
+
+/**
+ * Reads a byte of the EEPROM, leaving its address in EEAR.
+ */
+static uint8_t read_byte(const uint16_t ADDRESS)
+{
+    while (EECR & (1 << EEPE))
+        ;
+    EEAR = ADDRESS;
+    EECR |= 1 << EERE;
+    return EEDR;
+}
+
+static uint8_t checksum(const struct record *RECORD)
+{
+    const uint8_t *bytes = (const uint8_t *) RECORD;
+    uint8_t sum = CHECK_SEED;
+    for (uint8_t i = 0; i < offsetof(struct record, check); i++)
+        sum = (sum << 1 | sum >> 7) ^ bytes[i]; // rotated, so swapped bytes do not cancel out
+    return sum;
+}
+
+/**
+ * Interruption routine for the EEPROM ready: starts writing the next byte of the pending record that differs from the EEPROM,
+ * or stops when the record is complete.
+ */
+ISR(EE_READY_vect)
+{
+    const uint8_t *bytes = (const uint8_t *) &pending;
+    while (written < sizeof(pending))
+    {
+        uint8_t byte = bytes[written];
+        if (read_byte(pending_address + written++) != byte)
+        {
+            EEDR = byte;
+            EECR |= 1 << EEMPE;
+            EECR |= 1 << EEPE;  // within 4 cycles of EEMPE
+            return;
+        }
+    }
+    EECR &= ~(1 << EERIE);
+}
+
+void store_init()
+{
+    // the newest record is followed by a slot that does not continue its sequence
+    uint8_t slot = 0;
+    uint8_t seq = read_byte(slot_address(0));
+    for (uint8_t i = 0; i < STORE_SLOTS; i++)
+    {
+        uint8_t next = read_byte(slot_address((i + 1) % STORE_SLOTS));
+        if (seq != SEQ_ERASED && next != next_seq(seq))
+        {
+            slot = i;
+            break;
+        }
+        seq = next;
+    }
+
+    // from there back, the first record that checks (the newest may have been cut short)
+    struct record record;
+    for (uint8_t i = 0; i < STORE_SLOTS; i++, slot = slot ? slot - 1 : STORE_SLOTS - 1)
+    {
+        uint8_t *bytes = (uint8_t *) &record;
+        for (uint8_t j = 0; j < sizeof(record); j++)
+            bytes[j] = read_byte(slot_address(slot) + j);
+        if (record.seq != SEQ_ERASED && record.check == checksum(&record))
+        {
+            stats = record.stats;
+            last_slot = slot;
+            last_seq = record.seq;
+            return;
+        }
+    }
+    memset(&stats, 0, sizeof(stats));
+}
+
+const struct store_stats *store_get()
+{
+    return &stats;
+}
+
+/**
+ * Starts writing the statistics as a new record, in the slot after the newest one.
+ */
+static void save()
+{
+    if (store_busy())
+        return;
+    last_slot = (last_slot + 1) % STORE_SLOTS;
+    last_seq = next_seq(last_seq);
+    pending.seq = last_seq;
+    pending.stats = stats;
+    pending.check = checksum(&pending);
+    pending_address = slot_address(last_slot);
+    written = 0;
+    EECR |= 1 << EERIE;     // the interruption comes right away, the EEPROM being ready
+}
+
+uint8_t store_add_game(const uint16_t POINTS, const uint16_t MISSES)
+{
+    stats.games++;
+    stats.hits += POINTS;
+    stats.misses += MISSES;
+
+    uint8_t rank = STORE_SCORES;
+    while (rank && POINTS > stats.scores[rank - 1])
+        rank--;
+    if (rank < STORE_SCORES)
+    {
+        memmove(&stats.scores[rank + 1], &stats.scores[rank], (STORE_SCORES - 1 - rank) * sizeof(stats.scores[0]));
+        stats.scores[rank] = POINTS;
+    }
+
+    save();
+    return rank;
+}
+
+uint8_t store_busy()
+{
+    return (EECR & (1 << EERIE)) != 0;
+}
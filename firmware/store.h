@@ -0,0 +1,49 @@
+#ifndef __STORE_H__
+#define __STORE_H__
+
+#include <stdint.h>
+
+/**
+ * Scores and lifetime statistics kept in the EEPROM. Each save writes a whole record to the next slot of a ring, so the writes
+ * are spread over all the slots (wear levelling), and the record before it stays intact until the new one is complete. Records
+ * carry a sequence number and a checksum written last: at startup the newest record is the one where the sequence numbers of
+ * the ring stop following each other, and a record cut short by a reset is skipped for the one before it.
+ *
+ * The bytes are written by the EEPROM ready interruption (about 3.4 ms each, one record takes some 60 ms), so saving never
+ * waits for the EEPROM. Bytes that are already right are not written again.
+ */
+#define STORE_SCORES  3       // size of the score table
+
+struct store_stats
+{
+    uint16_t scores[STORE_SCORES];  // best points, highest first (0 for an empty entry)
+    uint16_t games;                 // games played
+    uint32_t hits;                  // moles hit, over all the games
+    uint32_t misses;                // wrong holes and moles gone away, over all the games
+};
+
+/**
+ * Loads the newest valid record; the statistics start empty if there is none.
+ */
+void store_init();
+
+/**
+ * @return the statistics (in RAM, up to date even while they are being saved)
+ */
+const struct store_stats *store_get();
+
+/**
+ * Adds a game to the statistics and to the score table, and starts saving them in background. If the previous save is still
+ * in progress, this one is skipped: the next save will carry the game along.
+ * @param POINTS the points of the game
+ * @param MISSES the misses of the game
+ * @return the position of the game in the score table (0 for the best), STORE_SCORES if it is not in the table
+ */
+uint8_t store_add_game(const uint16_t POINTS, const uint16_t MISSES);
+
+/**
+ * @return 1 while a record is being written (the EEPROM interruption cannot wake the MCU up from power-down), 0 otherwise
+ */
+uint8_t store_busy();
+
+#endif
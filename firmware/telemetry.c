@@ -0,0 +1,78 @@
+#include <avr/interrupt.h>
+#include "telemetry.h"
+#include "ticks.h"
+
+#ifdef TELEMETRY
+
+#define UBRR_VALUE ((F_CPU + USART_BAUD * 4UL) / (USART_BAUD * 8UL) - 1) // double speed mode, rounded (57600 bps: -0.8%)
+
+static uint8_t buffer[TELEMETRY_BUFFER_SIZE];
+static volatile uint8_t head = 0;   // next free byte, only written by telemetry_send()
+static volatile uint8_t tail = 0;   // next byte to send, only written by the interruption routine
+static uint16_t dropped = 0;
+
+/**
+ * Interruption routine for the USART data register empty: sends the next byte, or stops until the next record is queued.
+ */
+ISR(USART_UDRE_vect)
+{
+    uint8_t t = tail;
+    if (t == head)
+    {
+        UCSR0B &= ~(1 << UDRIE0);
+        return;
+    }
+    UDR0 = buffer[t];
+    tail = (t + 1) & (TELEMETRY_BUFFER_SIZE - 1);
+}
+
+void telemetry_init()
+{
+    UBRR0 = UBRR_VALUE;
+    UCSR0A = (1 << U2X0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);  // 8 data bits, no parity, 1 stop bit
+    UCSR0B = (1 << TXEN0);
+}
+
+static inline void put(uint8_t *h, const uint8_t BYTE)
+{
+    buffer[*h] = BYTE;
+    *h = (*h + 1) & (TELEMETRY_BUFFER_SIZE - 1);
+}
+
+uint8_t telemetry_send(const uint8_t TYPE, const uint8_t *PAYLOAD, const uint8_t SIZE)
+{
+    uint8_t h = head;
+    uint8_t free = (tail - h - 1) & (TELEMETRY_BUFFER_SIZE - 1);
+    if (free < SIZE + 5)
+    {
+        dropped++;
+        return 0;
+    }
+
+    uint16_t time = ticks_now();
+    uint8_t checksum = TYPE ^ (time & 0xFF) ^ (time >> 8);
+    put(&h, TELEMETRY_SYNC);
+    put(&h, TYPE);
+    put(&h, time & 0xFF);
+    put(&h, time >> 8);
+    for (uint8_t i = 0; i < SIZE; i++)
+    {
+        put(&h, PAYLOAD[i]);
+        checksum ^= PAYLOAD[i];
+    }
+    put(&h, checksum);
+
+    // the record is only visible to the interruption routine once it is complete. The routine may clear UDRIE0 between the
+    // read and the write below, but then it has seen the buffer empty, and setting it again is what is wanted
+    head = h;
+    UCSR0B |= (1 << UDRIE0);
+    return 1;
+}
+
+uint16_t telemetry_dropped()
+{
+    return dropped;
+}
+
+#endif
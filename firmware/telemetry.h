@@ -0,0 +1,66 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include <stdint.h>
+
+/**
+ * Telemetry records, sent by the USART (TX only, 8N1 at USART_BAUD) from a ring buffer emptied by the data register empty
+ * interruption, so sending never waits for the line. A record that does not fit in the buffer is dropped, whole.
+ *
+ * Record layout (multi-byte fields are little endian):
+ *   0xA5 (sync) | type | time (uint16, ticks_now()) | payload (size given by the type) | checksum (XOR of type to payload)
+ *
+ * Payload of each type:
+ *   TELEMETRY_HIT   hole (uint8), points (uint16)
+ *   TELEMETRY_MISS  hole pressed (uint8, TELEMETRY_TIMEOUT if the mole went away), misses in a row (uint8)
+ *   TELEMETRY_MOVE  hole a mole popped up from (uint8)
+ *   TELEMETRY_TICK  seconds left (uint8)
+ *   TELEMETRY_PERF  longest frame (uint16, Timer 1 counts), bytes sent to the LCD (uint16), scheduler loops (uint16), CPU load
+ *                   (uint8, %), all over the last second
+ *   TELEMETRY_PROF  probe (uint8), min (uint16), max (uint16), count (uint16), sum (uint32), in Timer 1 counts (see prof.h)
+ *   TELEMETRY_TASK  task (uint8, its place in the task table), longest run (uint16, Timer 1 counts), overruns (uint16), sent for
+ *                   each task at the end of a game
+ *
+ * Only built with TELEMETRY defined (make TELEMETRY=1); otherwise the functions are empty and the calls compile to nothing.
+ */
+#define TELEMETRY_SYNC         0xA5
+#define TELEMETRY_BUFFER_SIZE  128     // must be a power of two, and hold a whole prof_dump()
+#define TELEMETRY_TIMEOUT      0xFF
+
+enum telemetry_type
+{
+    TELEMETRY_HIT = 1,
+    TELEMETRY_MISS,
+    TELEMETRY_MOVE,
+    TELEMETRY_TICK,
+    TELEMETRY_PERF,
+    TELEMETRY_PROF,
+    TELEMETRY_TASK
+};
+
+#ifdef TELEMETRY
+/**
+ * Configures the USART transmitter. PD1 (TXD) becomes an output.
+ */
+void telemetry_init();
+
+/**
+ * Queues a record, to be sent in background.
+ * @param TYPE the record type (enum telemetry_type)
+ * @param PAYLOAD the payload, as described above
+ * @param SIZE the payload size, in bytes
+ * @return 1 if the record was queued, 0 if it was dropped because the buffer is full
+ */
+uint8_t telemetry_send(const uint8_t TYPE, const uint8_t *PAYLOAD, const uint8_t SIZE);
+
+/**
+ * @return how many records were dropped because the buffer was full
+ */
+uint16_t telemetry_dropped();
+#else
+static inline void telemetry_init() {}
+static inline uint8_t telemetry_send(const uint8_t TYPE, const uint8_t *PAYLOAD, const uint8_t SIZE) { return 0; }
+static inline uint16_t telemetry_dropped() { return 0; }
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "ticks.h"
+
+volatile uint16_t tick_count = 0; // Timer 1 ticks since timer1_init()
+
+/**
+ * Interruption routine for Timer 1.
+ */
+ISR(TIMER1_COMPA_vect)
+{
+    tick_count++;
+}
+
+uint16_t ticks_now()
+{
+    uint16_t ticks;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ticks = tick_count;
+    }
+    return ticks;
+}
+
+uint32_t ticks_stamp()
+{
+    uint16_t ticks, counts;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ticks = tick_count;
+        counts = TCNT1;
+        // the counter may have just wrapped with its interruption still pending
+        if ((TIFR1 & (1 << OCF1A)) && counts < TICK_COUNTS / 2)
+            ticks++;
+    }
+    return (uint32_t) ticks * TICK_COUNTS + counts;
+}
+
+void timer1_init()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        // resets counters for Timer 1
+        TCCR1A = 0;
+        TCCR1B = 0;
+        TCNT1  = 0;
+        tick_count = 0;
+        TIFR1 = (1 << OCF1A);
+        // sets register output compare
+        OCR1A = TICK_COUNTS - 1;
+        // sets TCT mode
+        TCCR1B |= (1 << WGM12);
+        // sets CS10 and CS11 for 64 prescaler
+        TCCR1B |= (1 << CS11) | (1 << CS10);
+        // enables timer1 mask
+        TIMSK1 |= (1 << OCIE1A);
+    }
+}
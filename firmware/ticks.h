@@ -0,0 +1,41 @@
+#ifndef __TICKS_H__
+#define __TICKS_H__
+
+#include <stdint.h>
+
+/**
+ * Constants for setting timer.
+ */
+#define TIMER_CLK		(F_CPU / 64)
+#define IRQ_FREQ		100                 // number of interruptions per second (scheduler ticks)
+#define TICK_COUNTS		(TIMER_CLK / IRQ_FREQ) // Timer 1 counts per tick
+
+/**
+ * Converts milliseconds to ticks, at compile time.
+ */
+#define MS_TO_TICKS(ms)	((uint16_t) ((uint32_t) (ms) * IRQ_FREQ / 1000))
+
+/**
+ * Converts Timer 1 counts to microseconds.
+ */
+#define COUNTS_TO_US(counts)	((uint32_t) (counts) * (1000000UL / TIMER_CLK))
+
+/**
+ * Initiates/resets Timer 1 and the tick counter.
+ */
+void timer1_init();
+
+/**
+ * Reads the tick counter. The 16-bit read takes two instructions, so it is done with interruptions disabled to keep the
+ * Timer 1 ISR from updating the counter halfway through.
+ * @return how many ticks have been generated by Timer 1 since timer1_init()
+ */
+uint16_t ticks_now();
+
+/**
+ * Fine grained timestamp, safe to call from interruption routines.
+ * @return how many Timer 1 counts (1/TIMER_CLK s, 4 us) have passed since timer1_init()
+ */
+uint32_t ticks_stamp();
+
+#endif